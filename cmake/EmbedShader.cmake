@@ -0,0 +1,18 @@
+# Converts a SPIR-V binary into a header holding a constexpr uint32_t array.
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DNAME=<IDENTIFIER> -P EmbedShader.cmake
+
+file(READ ${INPUT} content HEX)
+string(LENGTH "${content}" length)
+math(EXPR remainder "${length} % 8")
+if(NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not a valid SPIR-V binary.")
+endif()
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1U, " words "${content}")
+string(REGEX REPLACE "(([^ ]+ ){8})" "\\1\n    " words "${words}")
+file(WRITE ${OUTPUT}
+    "#pragma once\n\n"
+    "#include <cstdint>\n\n"
+    "inline constexpr uint32_t ${NAME}[] = {\n"
+    "    ${words}\n"
+    "};\n"
+)
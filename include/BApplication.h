@@ -28,6 +28,12 @@ private:
 public:
     int Exec();
 
+private:
+    void DrawFrame();
+
+public:
+    static constexpr BVulkanRenderSystem::CullMode CULL_MODE{BVulkanRenderSystem::CullMode::eFrustum};
+
 private:
     BCanvas* main_canvas_{};
 
@@ -35,5 +41,6 @@ private:
     BVulkanDevice* device_{};
     BVulkanRender* render_{};
     std::vector<BVulkanModel> models_{};
+    std::vector<BVulkanRenderSystem::RenderObject> objects_{};
     BVulkanRenderSystem* render_system_{};
 };
\ No newline at end of file
@@ -6,10 +6,32 @@
  * @date 2023-04-28
  */
 
+#include "BVulkanAllocator.h"
+#include "BVulkanBuffer.h"
+#include "BVulkanComputePipeline.h"
+#include "BVulkanCullSystem.h"
+#include "BVulkanDeletionQueue.h"
 #include "BVulkanDevice.h"
+#include "BVulkanFrameContext.h"
+#include "BVulkanFrustumCuller.h"
+#include "BVulkanGeometryArena.h"
 #include "BVulkanHeader.h"
+#include "BVulkanImage.h"
+#include "BVulkanMeshOptimizer.h"
 #include "BVulkanModel.h"
 #include "BVulkanPipeline.h"
+#include "BVulkanPipelineHandle.h"
+#include "BVulkanPipelineLayoutCache.h"
+#include "BVulkanPipelineLibrary.h"
+#include "BVulkanPipelineRegistry.h"
+#include "BVulkanQuantizer.h"
+#include "BVulkanRangeAllocator.h"
 #include "BVulkanRender.h"
 #include "BVulkanRenderSystem.h"
+#include "BVulkanRingBuffer.h"
+#include "BVulkanShaderLibrary.h"
+#include "BVulkanShaderReflection.h"
 #include "BVulkanSwapchain.h"
+#include "BVulkanThreadPool.h"
+#include "BVulkanTimeline.h"
+#include "BVulkanUploader.h"
@@ -0,0 +1,75 @@
+#pragma once
+
+/**
+ * @file BVulkanAllocator.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-06
+ */
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BVulkanHeader.h"
+#include "BVulkanRangeAllocator.h"
+
+class BVulkanAllocator {
+public:
+    struct Allocation {
+        vk::DeviceMemory memory_{};
+        vk::DeviceSize offset_{0};
+        vk::DeviceSize size_{0};
+        void* mapped_{nullptr};
+        uint32_t pool_{0};
+        bool dedicated_{false};
+
+        operator bool() const {
+            return static_cast<bool>(memory_);
+        }
+    };
+
+public:
+    BVulkanAllocator(vk::PhysicalDevice physical, vk::Device device);
+    ~BVulkanAllocator();
+    BVulkanAllocator(const BVulkanAllocator& allocator) = delete;
+    BVulkanAllocator(BVulkanAllocator&& allocator) = delete;
+    BVulkanAllocator& operator=(const BVulkanAllocator& allocator) = delete;
+    BVulkanAllocator& operator=(BVulkanAllocator&& allocator) = delete;
+
+public:
+    Allocation Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool linear);
+    void Free(Allocation& allocation);
+    uint32_t FindMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) const;
+
+private:
+    struct Block {
+        vk::DeviceMemory memory_{};
+        void* mapped_{nullptr};
+        BVulkanRangeAllocator ranges_{};
+    };
+
+    struct Pool {
+        uint32_t memory_type_{0};
+        vk::DeviceSize block_size_{0};
+        std::vector<std::unique_ptr<Block>> blocks_{};
+    };
+
+private:
+    Allocation AllocateDedicated(const vk::MemoryRequirements& requirements, uint32_t memory_type);
+    bool TryFindMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties, uint32_t& memory_type) const;
+    bool AllocateFromBlock(Block& block, const vk::MemoryRequirements& requirements, Allocation& allocation) const;
+    std::unique_ptr<Block> CreateBlock(uint32_t memory_type, vk::DeviceSize size);
+    uint32_t PoolIndex(uint32_t memory_type, bool linear) const;
+    void* MapIfHostVisible(vk::DeviceMemory memory, uint32_t memory_type) const;
+    vk::DeviceSize PreferredBlockSize(uint32_t memory_type) const;
+
+public:
+    static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE{64ULL * 1024 * 1024};
+
+private:
+    vk::PhysicalDevice physical_{};
+    vk::Device device_{};
+    vk::PhysicalDeviceMemoryProperties memory_properties_{};
+    vk::DeviceSize buffer_image_granularity_{1};
+    std::vector<Pool> pools_{};
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * @file BVulkanBuffer.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-08
+ */
+
+#include "BVulkanAllocator.h"
+#include "BVulkanHeader.h"
+
+class BVulkanDevice;
+
+class BVulkanBuffer {
+public:
+    BVulkanBuffer() = default;
+    BVulkanBuffer(BVulkanDevice* device, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties);
+    ~BVulkanBuffer();
+    BVulkanBuffer(const BVulkanBuffer& buffer) = delete;
+    BVulkanBuffer(BVulkanBuffer&& buffer) noexcept;
+    BVulkanBuffer& operator=(const BVulkanBuffer& buffer) = delete;
+    BVulkanBuffer& operator=(BVulkanBuffer&& buffer) noexcept;
+
+public:
+    const vk::Buffer& Buffer() const;
+    vk::DeviceSize Size() const;
+    void* Mapped() const;
+    void Release();
+
+    operator bool() const {
+        return static_cast<bool>(buffer_);
+    }
+
+private:
+    BVulkanDevice* device_{};
+    vk::Buffer buffer_{};
+    BVulkanAllocator::Allocation allocation_{};
+    vk::DeviceSize size_{0};
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+/**
+ * @file BVulkanComputePipeline.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-14
+ */
+
+#include <cstdint>
+#include <span>
+
+#include "BVulkanHeader.h"
+
+class BVulkanDevice;
+
+class BVulkanComputePipeline {
+public:
+    BVulkanComputePipeline(BVulkanDevice* device, std::span<const uint32_t> comp_shader_code, const vk::PipelineLayout& pipeline_layout);
+    ~BVulkanComputePipeline();
+    BVulkanComputePipeline(const BVulkanComputePipeline& pipeline) = delete;
+    BVulkanComputePipeline(BVulkanComputePipeline&& pipeline) = delete;
+    BVulkanComputePipeline& operator=(const BVulkanComputePipeline& pipeline) = delete;
+    BVulkanComputePipeline& operator=(BVulkanComputePipeline&& pipeline) = delete;
+
+public:
+    void Bind(const vk::CommandBuffer& buffer);
+
+private:
+    void CreateComputePipeline(std::span<const uint32_t> comp_shader_code, const vk::PipelineLayout& pipeline_layout);
+    vk::ShaderModule CreateShaderModule(std::span<const uint32_t> code);
+
+private:
+    BVulkanDevice* device_;
+    vk::Pipeline compute_pipeline_{};
+    vk::ShaderModule comp_shader_module_{};
+};
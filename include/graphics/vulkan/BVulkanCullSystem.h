@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ * @file BVulkanCullSystem.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-14
+ */
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BVulkanBuffer.h"
+#include "BVulkanHeader.h"
+#include "BVulkanImage.h"
+#include "BVulkanRingBuffer.h"
+
+class BVulkanDevice;
+class BVulkanComputePipeline;
+
+class BVulkanCullSystem {
+public:
+    struct CullObject {
+        glm::vec4 sphere_{0.0F};
+        uint32_t instance_{0};
+        uint32_t command_{0};
+        uint32_t first_instance_{0};
+        uint32_t padding_{0};
+    };
+
+    struct CullParams {
+        std::array<glm::vec4, 6> planes_{};
+        glm::mat4 pyramid_view_projection_{1.0F};
+        glm::vec4 pyramid_size_{0.0F};
+        uint32_t object_count_{0};
+        uint32_t occlusion_{0};
+        std::array<uint32_t, 2> padding_{};
+    };
+
+    struct PyramidPushConstantData {
+        glm::uvec2 source_size_{0};
+        glm::uvec2 destination_size_{0};
+    };
+
+public:
+    BVulkanCullSystem(BVulkanDevice* device, size_t frame_count);
+    ~BVulkanCullSystem();
+    BVulkanCullSystem(const BVulkanCullSystem& system) = delete;
+    BVulkanCullSystem(BVulkanCullSystem&& system) = delete;
+    BVulkanCullSystem& operator=(const BVulkanCullSystem& system) = delete;
+    BVulkanCullSystem& operator=(BVulkanCullSystem&& system) = delete;
+
+public:
+    void BeginFrame(size_t frame_index);
+    void SetOcclusion(bool occlusion);
+    void Cull(vk::CommandBuffer& command_buffer, const glm::mat4& view_projection, const BVulkanRingBuffer::Allocation& instances, vk::DeviceSize instance_size, const BVulkanRingBuffer::Allocation& commands, vk::DeviceSize command_size, const std::vector<CullObject>& objects);
+    void BuildDepthPyramid(vk::CommandBuffer& command_buffer, const BVulkanImage& depth_image, const vk::Extent2D& depth_extent, const glm::mat4& view_projection);
+    const vk::Buffer& GetInstanceBuffer() const;
+
+private:
+    void CreateSampler();
+    void CreateCullLayout();
+    void CreatePyramidLayout();
+    void CreateDescriptorSets();
+    void CreateDepthPyramid(uint32_t width, uint32_t height);
+    void DestroyDepthPyramid();
+    void TransitionDepthPyramid(vk::CommandBuffer& command_buffer, vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access);
+
+public:
+    static constexpr uint32_t CULL_GROUP_SIZE{64};
+    static constexpr uint32_t PYRAMID_GROUP_SIZE{8};
+    static constexpr vk::DeviceSize DEFAULT_OBJECT_CAPACITY{1024};
+
+private:
+    BVulkanDevice* device_;
+    size_t frame_count_{0};
+    size_t frame_index_{0};
+    bool occlusion_{false};
+    vk::Sampler sampler_{};
+    vk::DescriptorSetLayout cull_set_layout_{};
+    vk::PipelineLayout cull_pipeline_layout_{};
+    std::unique_ptr<BVulkanComputePipeline> cull_pipeline_{};
+    vk::DescriptorSetLayout pyramid_set_layout_{};
+    vk::PipelineLayout pyramid_pipeline_layout_{};
+    std::unique_ptr<BVulkanComputePipeline> pyramid_pipeline_{};
+    vk::DescriptorPool cull_descriptor_pool_{};
+    std::vector<vk::DescriptorSet> cull_sets_{};
+    std::unique_ptr<BVulkanRingBuffer> object_ring_{};
+    std::vector<BVulkanBuffer> instance_buffers_{};
+    BVulkanImage depth_pyramid_{};
+    std::vector<vk::ImageView> pyramid_views_{};
+    vk::DescriptorPool pyramid_descriptor_pool_{};
+    std::vector<vk::DescriptorSet> pyramid_source_sets_{};
+    std::vector<vk::DescriptorSet> pyramid_mip_sets_{};
+    vk::Extent2D depth_extent_{};
+    bool pyramid_initialized_{false};
+    bool pyramid_valid_{false};
+    glm::mat4 pyramid_view_projection_{1.0F};
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * @file BVulkanDeletionQueue.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-08
+ */
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+class BVulkanTimeline;
+class BVulkanUploader;
+
+class BVulkanDeletionQueue {
+public:
+    BVulkanDeletionQueue(const BVulkanTimeline* timeline, const BVulkanUploader* uploader);
+    ~BVulkanDeletionQueue();
+    BVulkanDeletionQueue(const BVulkanDeletionQueue& queue) = delete;
+    BVulkanDeletionQueue(BVulkanDeletionQueue&& queue) = delete;
+    BVulkanDeletionQueue& operator=(const BVulkanDeletionQueue& queue) = delete;
+    BVulkanDeletionQueue& operator=(BVulkanDeletionQueue&& queue) = delete;
+
+public:
+    void Push(std::function<void()>&& deleter);
+    void Collect();
+    void Flush();
+
+private:
+    struct Entry {
+        uint64_t value_{0};
+        uint64_t upload_value_{0};
+        std::function<void()> deleter_{};
+    };
+
+private:
+    const BVulkanTimeline* timeline_{};
+    const BVulkanUploader* uploader_{};
+    std::deque<Entry> entries_{};
+};
@@ -6,25 +6,45 @@
  * @date 2023-04-28
  */
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "BVulkanAllocator.h"
+#include "BVulkanDeletionQueue.h"
 #include "BVulkanHeader.h"
 
+class BVulkanGeometryArena;
+class BVulkanPipelineLayoutCache;
+class BVulkanPipelineRegistry;
+class BVulkanShaderLibrary;
+class BVulkanTimeline;
+class BVulkanUploader;
+
 class BVulkanDevice {
 public:
     struct QueueFamilyIndices {
         uint32_t graphics_family_;
         uint32_t present_family_;
+        uint32_t transfer_family_;
 
         bool has_graphics_family_ = false;
         bool has_present_family_ = false;
+        bool has_transfer_family_ = false;
 
         operator bool() {
             return has_graphics_family_ && has_present_family_;
         }
     };
 
+    struct PipelineCacheStatistics {
+        bool warm_{false};
+        uint32_t pipeline_count_{0};
+        std::chrono::duration<double, std::milli> creation_time_{0.0};
+    };
+
     struct SwapchainSupportDetails {
         vk::SurfaceCapabilitiesKHR capabilities_;
         std::vector<vk::SurfaceFormatKHR> formats_;
@@ -35,7 +55,7 @@ public:
 #if defined(_WIN32)
     explicit BVulkanDevice(const vk::Win32SurfaceCreateInfoKHR& surface_info);
 #endif
-    ~BVulkanDevice() = default;
+    ~BVulkanDevice();
     BVulkanDevice(const BVulkanDevice& device) = delete;
     BVulkanDevice(BVulkanDevice&& device) = delete;
     BVulkanDevice& operator=(const BVulkanDevice& device) = delete;
@@ -43,17 +63,35 @@ public:
 
 public:
     const vk::Device& Device() const;
-    void CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& memory);
+    const vk::PhysicalDeviceFeatures& GetEnabledFeatures() const;
+    const vk::DispatchLoaderDynamic& GetDispatcher() const;
+    bool HasDynamicRendering() const;
+    bool HasExtendedDynamicState() const;
+    bool HasGraphicsPipelineLibrary() const;
+    const vk::PipelineCache& GetPipelineCache() const;
+    const PipelineCacheStatistics& GetPipelineCacheStatistics() const;
+    void RecordPipelineCreation(std::chrono::duration<double, std::milli> creation_time);
+    void CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, BVulkanAllocator::Allocation& allocation);
+    void DestroyBuffer(vk::Buffer& buffer, BVulkanAllocator::Allocation& allocation);
     void CopyBuffer(const vk::Buffer& src, vk::Buffer& dst, vk::DeviceSize size);
     SwapchainSupportDetails GetSwapchainSupport() const;
     QueueFamilyIndices FindPhysicalQueueFamilies() const;
     const vk::CommandPool& GetCommandPool() const;
+    BVulkanUploader& GetUploader() const;
+    BVulkanDeletionQueue& GetDeletionQueue() const;
+    BVulkanTimeline& GetFrameTimeline() const;
+    BVulkanGeometryArena& GetGeometryArena() const;
+    BVulkanPipelineRegistry& GetPipelineRegistry() const;
+    BVulkanShaderLibrary& GetShaderLibrary() const;
+    BVulkanPipelineLayoutCache& GetPipelineLayoutCache() const;
     const vk::Queue& GetGraphicsQueue() const;
     const vk::Queue& GetPresentQueue() const;
+    const vk::Queue& GetTransferQueue() const;
     const vk::SurfaceKHR& Surface() const;
-    vk::ImageView CreateImageView(vk::Image& image, vk::Format format, vk::ImageAspectFlags aspect_flags);
+    vk::ImageView CreateImageView(vk::Image& image, vk::Format format, vk::ImageAspectFlags aspect_flags, uint32_t base_mip_level = 0, uint32_t mip_levels = 1);
     vk::Format FindSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features) const;
-    void CreateImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& memory);
+    void CreateImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, BVulkanAllocator::Allocation& allocation, uint32_t mip_levels = 1);
+    void DestroyImage(vk::Image& image, BVulkanAllocator::Allocation& allocation);
 
 private:
     void CreateInstance();
@@ -61,19 +99,24 @@ private:
     void PickPhysicalDevice();
     void CreateLogicalDevice();
     void CreateCommandPool();
+    void CreatePipelineCache();
+    void SavePipelineCache();
 
 private:
     bool CheckValidationLayerSupport() const;
     void CheckExtensionsSupport() const;
     std::vector<const char*> GetRequiredExtensions() const;
     static void PopulateDebugMessengerCreateInfo(vk::DebugUtilsMessengerCreateInfoEXT& create_info);
+    bool IsPipelineCacheCompatible(const std::vector<char>& data) const;
     bool IsPhysicalDeviceSuitable(const vk::PhysicalDevice& device) const;
     QueueFamilyIndices FindQueueFamilies(const vk::PhysicalDevice& device) const;
     SwapchainSupportDetails QuerySwapchainSupport(const vk::PhysicalDevice& device) const;
-    uint32_t FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties);
     vk::CommandBuffer BeginSingleTimeCommands();
     void EndSingleTimeCommands(vk::CommandBuffer command_buffer);
 
+public:
+    static constexpr const char* PIPELINE_CACHE_PATH{"pipeline_cache.bin"};
+
 private:
     vk::Instance instance_{};
     vk::SurfaceKHR surface_{};
@@ -81,7 +124,24 @@ private:
     vk::Device device_{};
     vk::Queue graphics_queue_{};
     vk::Queue present_queue_{};
+    vk::Queue transfer_queue_{};
     vk::CommandPool command_pool_{};
+    vk::PipelineCache pipeline_cache_{};
+    PipelineCacheStatistics pipeline_cache_statistics_{};
+    std::mutex pipeline_cache_mutex_{};
+    vk::PhysicalDeviceFeatures enabled_features_{};
+    vk::DispatchLoaderDynamic dispatcher_{};
+    bool dynamic_rendering_{false};
+    bool extended_dynamic_state_{false};
+    bool graphics_pipeline_library_{false};
+    std::unique_ptr<BVulkanTimeline> frame_timeline_{};
+    std::unique_ptr<BVulkanAllocator> allocator_{};
+    std::unique_ptr<BVulkanUploader> uploader_{};
+    std::unique_ptr<BVulkanDeletionQueue> deletion_queue_{};
+    std::unique_ptr<BVulkanGeometryArena> geometry_arena_{};
+    std::unique_ptr<BVulkanShaderLibrary> shader_library_{};
+    std::unique_ptr<BVulkanPipelineLayoutCache> pipeline_layout_cache_{};
+    std::unique_ptr<BVulkanPipelineRegistry> pipeline_registry_{};
 
 #if defined(_WIN32)
     std::vector<const char*> device_extensions_ = {"VK_KHR_swapchain"};
@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+ * @file BVulkanFrameContext.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-20
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BVulkanHeader.h"
+#include "BVulkanRingBuffer.h"
+
+class BVulkanDevice;
+
+class BVulkanFrameContext {
+public:
+    BVulkanFrameContext(BVulkanDevice* device, size_t index);
+    ~BVulkanFrameContext();
+    BVulkanFrameContext(const BVulkanFrameContext& context) = delete;
+    BVulkanFrameContext(BVulkanFrameContext&& context) = delete;
+    BVulkanFrameContext& operator=(const BVulkanFrameContext& context) = delete;
+    BVulkanFrameContext& operator=(BVulkanFrameContext&& context) = delete;
+
+public:
+    size_t GetIndex() const;
+    vk::CommandBuffer Begin();
+    const vk::CommandBuffer& GetCommandBuffer() const;
+    std::vector<vk::Semaphore>& GetUploadSemaphores();
+    std::vector<uint64_t>& GetUploadWaitValues();
+    std::vector<vk::PipelineStageFlags>& GetUploadWaitStages();
+    BVulkanRingBuffer& GetUploadArena();
+    BVulkanRingBuffer& GetUniformArena();
+    vk::DescriptorSet AllocateDescriptorSet(const vk::DescriptorSetLayout& layout);
+
+private:
+    void CreateCommandBuffer();
+    vk::DescriptorPool CreateDescriptorPool();
+
+public:
+    static constexpr vk::DeviceSize DEFAULT_UPLOAD_ARENA_SIZE{1024 * 1024};
+    static constexpr vk::DeviceSize DEFAULT_UNIFORM_ARENA_SIZE{64 * 1024};
+    static constexpr uint32_t DESCRIPTOR_POOL_SET_COUNT{64};
+
+private:
+    BVulkanDevice* device_;
+    size_t index_{0};
+    vk::CommandPool command_pool_{};
+    vk::CommandBuffer command_buffer_{};
+    std::vector<vk::DescriptorPool> descriptor_pools_{};
+    size_t descriptor_pool_index_{0};
+    std::vector<vk::Semaphore> upload_semaphores_{};
+    std::vector<uint64_t> upload_wait_values_{};
+    std::vector<vk::PipelineStageFlags> upload_wait_stages_{};
+    std::unique_ptr<BVulkanRingBuffer> upload_arena_{};
+    std::unique_ptr<BVulkanRingBuffer> uniform_arena_{};
+};
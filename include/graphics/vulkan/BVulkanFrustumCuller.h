@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ * @file BVulkanFrustumCuller.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-15
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BVulkanHeader.h"
+
+class BVulkanFrustumCuller {
+public:
+    BVulkanFrustumCuller() = default;
+    ~BVulkanFrustumCuller() = default;
+    BVulkanFrustumCuller(const BVulkanFrustumCuller& culler) = delete;
+    BVulkanFrustumCuller(BVulkanFrustumCuller&& culler) = delete;
+    BVulkanFrustumCuller& operator=(const BVulkanFrustumCuller& culler) = delete;
+    BVulkanFrustumCuller& operator=(BVulkanFrustumCuller&& culler) = delete;
+
+public:
+    uint32_t Insert(const glm::vec3& local_min, const glm::vec3& local_max, const glm::mat4& transform);
+    void Update(uint32_t handle, const glm::mat4& transform);
+    void Remove(uint32_t handle);
+    void Clear();
+    size_t Size() const;
+    const glm::mat4& GetTransform(uint32_t handle) const;
+    void Cull(const glm::mat4& view_projection, std::vector<uint32_t>& visible);
+    static std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& view_projection);
+
+public:
+    static constexpr uint32_t BRANCH_FACTOR{4};
+    static constexpr uint32_t LEAF_SIZE{8};
+    static constexpr uint32_t INVALID_INDEX{0xFFFFFFFF};
+
+private:
+    struct Node {
+        alignas(16) std::array<float, BRANCH_FACTOR> min_x_{};
+        alignas(16) std::array<float, BRANCH_FACTOR> min_y_{};
+        alignas(16) std::array<float, BRANCH_FACTOR> min_z_{};
+        alignas(16) std::array<float, BRANCH_FACTOR> max_x_{};
+        alignas(16) std::array<float, BRANCH_FACTOR> max_y_{};
+        alignas(16) std::array<float, BRANCH_FACTOR> max_z_{};
+        std::array<uint32_t, BRANCH_FACTOR> child_{INVALID_INDEX, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX};
+        std::array<uint32_t, BRANCH_FACTOR> first_{};
+        std::array<uint32_t, BRANCH_FACTOR> count_{};
+        uint32_t parent_{INVALID_INDEX};
+        bool dirty_{true};
+    };
+
+private:
+    void ComputeWorldBox(uint32_t handle);
+    void Build();
+    uint32_t BuildNode(uint32_t parent, uint32_t begin, uint32_t end);
+    uint32_t SplitRange(uint32_t begin, uint32_t end);
+    void WriteSlot(uint32_t slot, uint32_t handle);
+    void Refit();
+    void RefitNode(Node& node);
+
+private:
+    std::vector<glm::vec3> local_min_{};
+    std::vector<glm::vec3> local_max_{};
+    std::vector<glm::mat4> transforms_{};
+    std::vector<glm::vec3> world_min_{};
+    std::vector<glm::vec3> world_max_{};
+    std::vector<uint32_t> handle_slot_{};
+    std::vector<uint32_t> free_handles_{};
+    size_t size_{0};
+
+    std::vector<uint32_t> slot_handle_{};
+    std::vector<uint32_t> slot_node_{};
+    std::vector<float> min_x_{};
+    std::vector<float> min_y_{};
+    std::vector<float> min_z_{};
+    std::vector<float> max_x_{};
+    std::vector<float> max_y_{};
+    std::vector<float> max_z_{};
+    std::vector<Node> nodes_{};
+    std::vector<uint32_t> stack_{};
+    bool needs_build_{false};
+    bool needs_refit_{false};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+/**
+ * @file BVulkanGeometryArena.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-12
+ */
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "BVulkanBuffer.h"
+#include "BVulkanHeader.h"
+#include "BVulkanRangeAllocator.h"
+
+class BVulkanDevice;
+
+class BVulkanGeometryArena {
+public:
+    struct Range {
+        uint32_t page_{0};
+        uint32_t offset_{0};
+        uint32_t count_{0};
+
+        operator bool() const {
+            return count_ != 0;
+        }
+    };
+
+public:
+    explicit BVulkanGeometryArena(BVulkanDevice* device, vk::DeviceSize page_size = DEFAULT_PAGE_SIZE);
+    ~BVulkanGeometryArena() = default;
+    BVulkanGeometryArena(const BVulkanGeometryArena& arena) = delete;
+    BVulkanGeometryArena(BVulkanGeometryArena&& arena) = delete;
+    BVulkanGeometryArena& operator=(const BVulkanGeometryArena& arena) = delete;
+    BVulkanGeometryArena& operator=(BVulkanGeometryArena&& arena) = delete;
+
+public:
+    Range AllocateVertices(const void* data, uint32_t stride, uint32_t count);
+    Range AllocateIndices(const void* data, vk::IndexType index_type, uint32_t count);
+    void FreeVertices(uint32_t stride, Range& range);
+    void FreeIndices(vk::IndexType index_type, Range& range);
+    const vk::Buffer& VertexBuffer(uint32_t stride, uint32_t page) const;
+    const vk::Buffer& IndexBuffer(vk::IndexType index_type, uint32_t page) const;
+
+private:
+    struct Page {
+        BVulkanBuffer buffer_{};
+        BVulkanRangeAllocator ranges_{};
+    };
+
+    struct Pool {
+        uint32_t stride_{0};
+        vk::BufferUsageFlags usage_{};
+        std::vector<Page> pages_{};
+    };
+
+private:
+    Range Allocate(Pool& pool, const void* data, uint32_t count);
+    void Free(Pool& pool, Range& range);
+    Pool& GetVertexPool(uint32_t stride);
+    Pool& GetIndexPool(vk::IndexType index_type);
+    const Pool& GetIndexPool(vk::IndexType index_type) const;
+
+public:
+    static constexpr vk::DeviceSize DEFAULT_PAGE_SIZE{32ULL * 1024 * 1024};
+
+private:
+    BVulkanDevice* device_{};
+    vk::DeviceSize page_size_{0};
+    std::map<uint32_t, Pool> vertex_pools_{};
+    Pool index16_pool_{};
+    Pool index32_pool_{};
+};
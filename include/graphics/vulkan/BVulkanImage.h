@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * @file BVulkanImage.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-08
+ */
+
+#include <cstdint>
+
+#include "BVulkanAllocator.h"
+#include "BVulkanHeader.h"
+
+class BVulkanDevice;
+
+class BVulkanImage {
+public:
+    BVulkanImage() = default;
+    BVulkanImage(BVulkanDevice* device, uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::ImageAspectFlags aspect, uint32_t mip_levels = 1);
+    ~BVulkanImage();
+    BVulkanImage(const BVulkanImage& image) = delete;
+    BVulkanImage(BVulkanImage&& image) noexcept;
+    BVulkanImage& operator=(const BVulkanImage& image) = delete;
+    BVulkanImage& operator=(BVulkanImage&& image) noexcept;
+
+public:
+    const vk::Image& Image() const;
+    const vk::ImageView& View() const;
+    vk::Format Format() const;
+    vk::ImageUsageFlags Usage() const;
+    vk::ImageAspectFlags Aspect() const;
+    vk::Extent2D Extent() const;
+    uint32_t MipLevels() const;
+    void Release();
+
+    operator bool() const {
+        return static_cast<bool>(image_);
+    }
+
+private:
+    BVulkanDevice* device_{};
+    vk::Image image_{};
+    vk::ImageView view_{};
+    BVulkanAllocator::Allocation allocation_{};
+    vk::Format format_{vk::Format::eUndefined};
+    vk::ImageUsageFlags usage_{};
+    vk::Extent2D extent_{};
+    uint32_t mip_levels_{1};
+};
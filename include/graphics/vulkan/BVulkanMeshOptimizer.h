@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * @file BVulkanMeshOptimizer.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-11
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BVulkanMeshOptimizer {
+public:
+    struct Statistics {
+        float acmr_{0.0F};
+        float atvr_{0.0F};
+    };
+
+    struct Report {
+        Statistics before_{};
+        Statistics after_{};
+    };
+
+public:
+    BVulkanMeshOptimizer() = delete;
+
+public:
+    static Statistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size = CACHE_SIZE);
+    static std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertex_count);
+    static std::vector<uint32_t> OptimizeOverdraw(const std::vector<uint32_t>& indices, const float* positions, size_t stride, size_t vertex_count, float threshold = OVERDRAW_THRESHOLD);
+    static std::vector<uint32_t> OptimizeVertexFetch(const std::vector<uint32_t>& indices, size_t vertex_count);
+    static std::vector<uint32_t> RemapIndices(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap);
+
+    template <typename T>
+    static std::vector<T> RemapVertices(const std::vector<T>& vertices, const std::vector<uint32_t>& remap) {
+        std::vector<T> result(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            result[remap[i]] = vertices[i];
+        }
+        return result;
+    }
+
+public:
+    static constexpr uint32_t CACHE_SIZE{32};
+    static constexpr float OVERDRAW_THRESHOLD{1.05F};
+};
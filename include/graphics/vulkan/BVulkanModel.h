@@ -6,41 +6,118 @@
  * @date 2023-04-28
  */
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
+#include "BVulkanGeometryArena.h"
 #include "BVulkanHeader.h"
+#include "BVulkanMeshOptimizer.h"
 
 class BVulkanDevice;
 
 class BVulkanModel {
 public:
+    enum class VertexFormat : uint32_t {
+        eFloat,
+        ePackedSnorm16,
+        ePackedHalf,
+    };
+
     struct Vertex {
         glm::vec3 position_;
         glm::vec4 color_;
+        glm::vec3 normal_;
         bool operator==(const Vertex& other) const;
         static std::vector<vk::VertexInputBindingDescription> GetBindingDescriptions();
         static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions();
     };
 
+    struct PackedVertex {
+        std::array<uint16_t, 4> position_;
+        std::array<uint8_t, 4> color_;
+        std::array<int16_t, 2> normal_;
+        static std::vector<vk::VertexInputBindingDescription> GetBindingDescriptions();
+        static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions(VertexFormat format);
+    };
+
+    struct Instance {
+        glm::mat4 transform_{1.0F};
+        glm::vec4 color_{1.0F};
+        glm::vec4 dequantization_scale_{1.0F};
+        glm::vec4 dequantization_offset_{0.0F};
+        glm::mat3x4 normal_matrix_{1.0F};
+        static std::vector<vk::VertexInputBindingDescription> GetBindingDescriptions();
+        static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions();
+    };
+
+    struct BoundingBox {
+        glm::vec3 min_{0.0F};
+        glm::vec3 max_{0.0F};
+    };
+
+    struct Builder {
+        std::vector<Vertex> vertices_{};
+        std::vector<uint32_t> indices_{};
+        VertexFormat format_{VertexFormat::eFloat};
+        bool optimize_{true};
+        BVulkanMeshOptimizer::Report report_{};
+
+        void LoadTriangles(const std::vector<Vertex>& triangles);
+        BVulkanMeshOptimizer::Report Optimize();
+    };
+
 public:
     BVulkanModel(BVulkanDevice* device, const std::vector<Vertex>& vertices);
+    BVulkanModel(BVulkanDevice* device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, VertexFormat format = VertexFormat::eFloat);
+    BVulkanModel(BVulkanDevice* device, const Builder& builder);
     ~BVulkanModel();
-    BVulkanModel(const BVulkanModel& model) = default;
-    BVulkanModel(BVulkanModel&& model) = default;
-    BVulkanModel& operator=(const BVulkanModel& model) = default;
-    BVulkanModel& operator=(BVulkanModel&& model) = default;
+    BVulkanModel(const BVulkanModel& model) = delete;
+    BVulkanModel(BVulkanModel&& model) noexcept;
+    BVulkanModel& operator=(const BVulkanModel& model) = delete;
+    BVulkanModel& operator=(BVulkanModel&& model) noexcept;
 
 public:
+    static std::vector<vk::VertexInputBindingDescription> GetBindingDescriptions(VertexFormat format);
+    static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions(VertexFormat format);
+    VertexFormat GetVertexFormat() const;
+    const glm::mat4& GetDequantization() const;
+    const glm::vec4& GetBoundingSphere() const;
+    const BoundingBox& GetBoundingBox() const;
+    const vk::Buffer& GetVertexBuffer() const;
+    const vk::Buffer& GetIndexBuffer() const;
+    vk::IndexType GetIndexType() const;
+    bool IsIndexed() const;
+    bool IsEmpty() const;
+    vk::DrawIndexedIndirectCommand GetDrawCommand(uint32_t instance_count, uint32_t first_instance) const;
     void Bind(vk::CommandBuffer& command_buffer) const;
-    void Draw(vk::CommandBuffer& command_buffer) const;
+    void Draw(vk::CommandBuffer& command_buffer, uint32_t instance_count = 1, uint32_t first_instance = 0) const;
+    void Release();
+
+public:
+    static constexpr uint32_t INSTANCE_BINDING{1};
+    static constexpr uint32_t INSTANCE_LOCATION{4};
 
 private:
     void CreateVertexBuffer(const std::vector<Vertex>& vertices);
+    void CreatePackedVertexBuffer(const std::vector<Vertex>& vertices);
+    void CreateIndexBuffer(const std::vector<uint32_t>& indices);
+    void ComputeBounds(const std::vector<Vertex>& vertices);
 
 private:
     BVulkanDevice* device_{};
-    vk::Buffer vertex_buffer_{};
-    vk::DeviceMemory vertex_buffer_memory_{};
-    uint32_t vertex_count_{0};
+    VertexFormat vertex_format_{VertexFormat::eFloat};
+    glm::mat4 dequantization_{1.0F};
+    glm::vec4 bounding_sphere_{0.0F};
+    BoundingBox bounding_box_{};
+    uint32_t vertex_stride_{0};
+    BVulkanGeometryArena::Range vertex_range_{};
+    BVulkanGeometryArena::Range index_range_{};
+    vk::IndexType index_type_{vk::IndexType::eUint32};
+};
+
+template <>
+struct std::hash<BVulkanModel::Vertex> {
+    size_t operator()(const BVulkanModel::Vertex& vertex) const;
 };
\ No newline at end of file
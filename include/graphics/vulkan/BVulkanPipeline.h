@@ -6,7 +6,11 @@
  * @date 2023-04-28
  */
 
-#include <string>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
 #include <vector>
 
 #include "BVulkanHeader.h"
@@ -15,9 +19,16 @@ class BVulkanDevice;
 
 class BVulkanPipeline {
 public:
+    struct SpecializationInfo {
+        std::vector<vk::SpecializationMapEntry> map_entries_{};
+        std::vector<uint8_t> data_{};
+    };
+
     struct PipelineConfigInfo {
         PipelineConfigInfo() = default;
 
+        std::vector<vk::VertexInputBindingDescription> binding_descriptions_{};
+        std::vector<vk::VertexInputAttributeDescription> attribute_descriptions_{};
         vk::PipelineViewportStateCreateInfo viewport_info_{};
         vk::PipelineInputAssemblyStateCreateInfo input_assembly_info_{};
         vk::PipelineRasterizationStateCreateInfo rasterization_info_{};
@@ -30,10 +41,16 @@ public:
         vk::PipelineLayout pipeline_layout_{nullptr};
         vk::RenderPass render_pass_{nullptr};
         uint32_t subpass_{0};
+        vk::Format color_attachment_format_{vk::Format::eUndefined};
+        vk::Format depth_attachment_format_{vk::Format::eUndefined};
+        SpecializationInfo vert_specialization_{};
+        SpecializationInfo frag_specialization_{};
     };
 
 public:
-    BVulkanPipeline(BVulkanDevice* device, const std::string& vert_shader_path, const std::string& frag_shader_path, const PipelineConfigInfo& config);
+    BVulkanPipeline(BVulkanDevice* device, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const PipelineConfigInfo& config);
+    BVulkanPipeline(BVulkanDevice* device, vk::GraphicsPipelineLibraryFlagsEXT library_parts, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const PipelineConfigInfo& config);
+    BVulkanPipeline(BVulkanDevice* device, std::span<const BVulkanPipeline* const> libraries, const PipelineConfigInfo& config, bool link_time_optimization);
     ~BVulkanPipeline();
     BVulkanPipeline(const BVulkanPipeline& pipeline) = delete;
     BVulkanPipeline(BVulkanPipeline&& pipeline) = delete;
@@ -42,12 +59,37 @@ public:
 
 public:
     static PipelineConfigInfo DefaultPipelineConfigInfo(vk::PrimitiveTopology primitive_topology = vk::PrimitiveTopology::eTriangleList);
+    static void EnableExtendedDynamicState(PipelineConfigInfo& config);
+    static bool IsDynamicState(const PipelineConfigInfo& config, vk::DynamicState dynamic_state);
     void Bind(const vk::CommandBuffer& buffer);
 
+    template <typename T>
+    static SpecializationInfo MakeSpecializationInfo(const T& constants, uint32_t first_constant_id = 0) {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(uint32_t) == 0 && alignof(T) == sizeof(uint32_t), "Specialization constants must be 32-bit scalars.");
+        SpecializationInfo info{};
+        info.data_.resize(sizeof(T));
+        std::memcpy(info.data_.data(), &constants, sizeof(T));
+        for (uint32_t i = 0; i < sizeof(T) / sizeof(uint32_t); ++i) {
+            info.map_entries_.push_back({first_constant_id + i, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t)});
+        }
+        return info;
+    }
+
 private:
-    void CreateGraphicsPipeline(const std::string& vert_shader_path, const std::string& frag_shader_path, const PipelineConfigInfo& config);
-    static std::vector<char> ReadFile(const std::string& path);
-    vk::ShaderModule CreateShaderModule(const std::vector<char>& code);
+    void CreateGraphicsPipeline(std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const PipelineConfigInfo& config, vk::GraphicsPipelineLibraryFlagsEXT library_parts = {});
+    void LinkGraphicsPipeline(std::span<const BVulkanPipeline* const> libraries, const PipelineConfigInfo& config, bool link_time_optimization);
+    vk::ShaderModule CreateShaderModule(std::span<const uint32_t> code);
+
+public:
+    static constexpr std::array<vk::DynamicState, 7> EXTENDED_DYNAMIC_STATES{
+        vk::DynamicState::eCullMode,
+        vk::DynamicState::eFrontFace,
+        vk::DynamicState::ePrimitiveTopology,
+        vk::DynamicState::eDepthTestEnable,
+        vk::DynamicState::eDepthWriteEnable,
+        vk::DynamicState::eDepthCompareOp,
+        vk::DynamicState::eDepthBoundsTestEnable,
+    };
 
 private:
     BVulkanDevice* device_;
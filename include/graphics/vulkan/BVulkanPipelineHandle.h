@@ -0,0 +1,40 @@
+#pragma once
+
+/**
+ * @file BVulkanPipelineHandle.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-22
+ */
+
+#include <chrono>
+#include <future>
+#include <memory>
+
+class BVulkanPipeline;
+
+class BVulkanPipelineHandle {
+public:
+    using PipelineFuture = std::shared_future<std::shared_ptr<BVulkanPipeline>>;
+
+public:
+    BVulkanPipelineHandle() = default;
+    BVulkanPipelineHandle(PipelineFuture future, PipelineFuture linked, PipelineFuture fallback);
+
+public:
+    bool IsReady() const;
+    BVulkanPipeline* Get() const;
+    void Wait() const;
+    PipelineFuture GetUsable() const;
+
+    operator bool() const {
+        return future_.valid();
+    }
+
+public:
+    static constexpr std::chrono::milliseconds WAIT_INTERVAL{1};
+
+private:
+    PipelineFuture future_{};
+    PipelineFuture linked_{};
+    PipelineFuture fallback_{};
+};
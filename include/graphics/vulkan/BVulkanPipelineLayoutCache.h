@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * @file BVulkanPipelineLayoutCache.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-18
+ */
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+#include "BVulkanHeader.h"
+
+class BVulkanDevice;
+
+class BVulkanPipelineLayoutCache {
+public:
+    struct Layout {
+        vk::PipelineLayout pipeline_layout_{};
+        std::vector<vk::DescriptorSetLayout> set_layouts_{};
+        vk::ShaderStageFlags push_constant_stages_{};
+        uint32_t push_constant_size_{0};
+    };
+
+public:
+    explicit BVulkanPipelineLayoutCache(BVulkanDevice* device);
+    ~BVulkanPipelineLayoutCache();
+    BVulkanPipelineLayoutCache(const BVulkanPipelineLayoutCache& cache) = delete;
+    BVulkanPipelineLayoutCache(BVulkanPipelineLayoutCache&& cache) = delete;
+    BVulkanPipelineLayoutCache& operator=(const BVulkanPipelineLayoutCache& cache) = delete;
+    BVulkanPipelineLayoutCache& operator=(BVulkanPipelineLayoutCache&& cache) = delete;
+
+public:
+    const Layout& GetLayout(const std::vector<std::string>& shader_names, const std::vector<std::pair<uint32_t, uint32_t>>& dynamic_bindings = {});
+    size_t Size() const;
+
+private:
+    vk::DescriptorSetLayout GetSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+
+private:
+    BVulkanDevice* device_;
+    mutable std::mutex mutex_{};
+    std::unordered_map<std::string, vk::DescriptorSetLayout> set_layouts_{};
+    std::unordered_map<std::string, Layout> layouts_{};
+};
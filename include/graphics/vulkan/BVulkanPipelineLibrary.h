@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+ * @file BVulkanPipelineLibrary.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-19
+ */
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "BVulkanHeader.h"
+#include "BVulkanPipeline.h"
+
+class BVulkanDevice;
+
+class BVulkanPipelineLibrary {
+public:
+    using PartFuture = std::shared_future<std::shared_ptr<BVulkanPipeline>>;
+
+public:
+    explicit BVulkanPipelineLibrary(BVulkanDevice* device);
+    ~BVulkanPipelineLibrary();
+    BVulkanPipelineLibrary(const BVulkanPipelineLibrary& library) = delete;
+    BVulkanPipelineLibrary(BVulkanPipelineLibrary&& library) = delete;
+    BVulkanPipelineLibrary& operator=(const BVulkanPipelineLibrary& library) = delete;
+    BVulkanPipelineLibrary& operator=(BVulkanPipelineLibrary&& library) = delete;
+
+public:
+    std::shared_ptr<BVulkanPipeline> Link(std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config, bool link_time_optimization);
+    size_t Size() const;
+    static std::string MakeKey(vk::GraphicsPipelineLibraryFlagBitsEXT part, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config);
+
+private:
+    std::shared_ptr<BVulkanPipeline> GetPart(vk::GraphicsPipelineLibraryFlagBitsEXT part, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config);
+
+public:
+    static constexpr std::array<vk::GraphicsPipelineLibraryFlagBitsEXT, 4> PARTS{
+        vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface,
+        vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders,
+        vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader,
+        vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface,
+    };
+
+private:
+    BVulkanDevice* device_;
+    mutable std::mutex mutex_{};
+    std::unordered_map<std::string, PartFuture> parts_{};
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+/**
+ * @file BVulkanPipelineRegistry.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-16
+ */
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "BVulkanHeader.h"
+#include "BVulkanPipeline.h"
+#include "BVulkanPipelineHandle.h"
+#include "BVulkanPipelineLibrary.h"
+#include "BVulkanThreadPool.h"
+
+class BVulkanDevice;
+
+class BVulkanPipelineRegistry {
+public:
+    using PipelineFuture = BVulkanPipelineHandle::PipelineFuture;
+    using Handle = BVulkanPipelineHandle;
+
+public:
+    explicit BVulkanPipelineRegistry(BVulkanDevice* device);
+    ~BVulkanPipelineRegistry();
+    BVulkanPipelineRegistry(const BVulkanPipelineRegistry& registry) = delete;
+    BVulkanPipelineRegistry(BVulkanPipelineRegistry&& registry) = delete;
+    BVulkanPipelineRegistry& operator=(const BVulkanPipelineRegistry& registry) = delete;
+    BVulkanPipelineRegistry& operator=(BVulkanPipelineRegistry&& registry) = delete;
+
+public:
+    Handle Acquire(const std::string& vert_shader_name, const std::string& frag_shader_name, const BVulkanPipeline::PipelineConfigInfo& config, const Handle& fallback = {});
+    size_t Size() const;
+    static std::string MakeKey(const std::string& vert_shader_name, std::span<const uint32_t> vert_shader_code, const std::string& frag_shader_name, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config);
+
+private:
+    struct Entry {
+        PipelineFuture future_{};
+        PipelineFuture linked_{};
+    };
+
+public:
+    static constexpr size_t MAX_THREAD_COUNT{4};
+
+private:
+    BVulkanDevice* device_;
+    mutable std::mutex mutex_{};
+    std::unordered_map<std::string, Entry> pipelines_{};
+    std::unique_ptr<BVulkanPipelineLibrary> library_{};
+    std::unique_ptr<BVulkanThreadPool> thread_pool_{};
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @file BVulkanQuantizer.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-10
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "BVulkanHeader.h"
+
+class BVulkanQuantizer {
+public:
+    BVulkanQuantizer() = delete;
+
+public:
+    static void ComputeBounds(const float* positions, size_t stride, size_t count, glm::vec3& min, glm::vec3& max);
+    static void QuantizeSnorm16(const float* positions, size_t stride, size_t count, const glm::vec3& center, const glm::vec3& half_extent, int16_t* dst, size_t dst_stride);
+    static void QuantizeHalf(const float* positions, size_t stride, size_t count, const glm::vec3& center, uint16_t* dst, size_t dst_stride);
+    static void QuantizeUnorm8(const float* colors, size_t stride, size_t count, uint8_t* dst, size_t dst_stride);
+    static void EncodeOctahedral(const float* normals, size_t stride, size_t count, int16_t* dst, size_t dst_stride);
+    static uint16_t FloatToHalf(float value);
+};
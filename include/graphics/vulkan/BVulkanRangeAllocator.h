@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * @file BVulkanRangeAllocator.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-12
+ */
+
+#include <map>
+
+#include "BVulkanHeader.h"
+
+class BVulkanRangeAllocator {
+public:
+    explicit BVulkanRangeAllocator(vk::DeviceSize size = 0);
+    ~BVulkanRangeAllocator() = default;
+    BVulkanRangeAllocator(const BVulkanRangeAllocator& allocator) = default;
+    BVulkanRangeAllocator(BVulkanRangeAllocator&& allocator) = default;
+    BVulkanRangeAllocator& operator=(const BVulkanRangeAllocator& allocator) = default;
+    BVulkanRangeAllocator& operator=(BVulkanRangeAllocator&& allocator) = default;
+
+public:
+    bool Allocate(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset);
+    void Free(vk::DeviceSize offset, vk::DeviceSize size);
+    vk::DeviceSize Size() const;
+    vk::DeviceSize Used() const;
+
+private:
+    vk::DeviceSize size_{0};
+    vk::DeviceSize used_{0};
+    std::map<vk::DeviceSize, vk::DeviceSize> free_ranges_{};
+};
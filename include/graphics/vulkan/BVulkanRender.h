@@ -6,19 +6,33 @@
  * @date 2023-04-28
  */
 
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "BVulkanHeader.h"
+#include "BVulkanSwapchain.h"
 
 class BVulkanDevice;
+class BVulkanFrameContext;
+class BVulkanImage;
 class BGraphicsCanvas;
-class BVulkanSwapchain;
 
 class BVulkanRender {
 public:
-    BVulkanRender(BVulkanDevice* device, BGraphicsCanvas* canvas);
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameTiming {
+        Clock::duration gpu_wait_{};
+        Clock::duration limiter_wait_{};
+        Clock::duration acquire_wait_{};
+        Clock::time_point latch_time_{};
+    };
+
+public:
+    BVulkanRender(BVulkanDevice* device, BGraphicsCanvas* canvas, const BVulkanSwapchain::Config& swapchain_config = {}, size_t frames_in_flight = DEFAULT_FRAMES_IN_FLIGHT);
     ~BVulkanRender();
     BVulkanRender(const BVulkanRender& render) = delete;
     BVulkanRender(BVulkanRender&& render) = delete;
@@ -27,24 +41,48 @@ public:
 
 public:
     const vk::RenderPass& GetSwapchainRenderPass() const;
+    const vk::Format& GetSwapchainColorFormat() const;
+    const vk::Format& GetSwapchainDepthFormat() const;
+    vk::Extent2D GetSwapchainExtent() const;
     float GetAspectRatio() const;
+    size_t GetFrameCount() const;
+    size_t GetFrameIndex() const;
+    BVulkanFrameContext& GetCurrentFrame() const;
+    const BVulkanImage& GetCurrentDepthImage() const;
+    const BVulkanSwapchain::Config& GetSwapchainConfig() const;
+    void SetSwapchainConfig(const BVulkanSwapchain::Config& config);
+    vk::PresentModeKHR GetPresentMode() const;
+    void SetFrameRateLimit(double frames_per_second);
+    const FrameTiming& GetFrameTiming() const;
     vk::CommandBuffer BeginFrame();
     void EndFrame();
     void BeginSwapchainRenderPass(vk::CommandBuffer command_buffer);
     void EndSwapchainRenderPass(vk::CommandBuffer command_buffer);
 
+public:
+    static constexpr size_t DEFAULT_FRAMES_IN_FLIGHT{2};
+    static constexpr std::array<float, 4> CLEAR_COLOR{0.17F, 0.17F, 0.17F, 1.0F};
+    static constexpr std::chrono::microseconds LIMITER_SPIN_TIME{1000};
+
 private:
-    void RecreateSwapchain();
-    void CreateCommandBuffers();
-    void FreeCommandBuffers();
+    bool RecreateSwapchain();
+    void LimitFrameRate();
+    void BeginDynamicRendering(vk::CommandBuffer command_buffer);
+    void EndDynamicRendering(vk::CommandBuffer command_buffer);
     bool IsFrameInProgress() const;
-    vk::CommandBuffer GetCurrentCommandBuffer() const;
 
 private:
     BVulkanDevice* device_{};
     BGraphicsCanvas* canvas_{};
-    std::vector<vk::CommandBuffer> command_buffers_{};
+    size_t frames_in_flight_{0};
+    std::vector<std::unique_ptr<BVulkanFrameContext>> frames_{};
     std::unique_ptr<BVulkanSwapchain> swapchain_{};
+    vk::Extent2D canvas_extent_{};
+    bool swapchain_dirty_{false};
+    bool depth_dirty_{false};
+    Clock::duration frame_interval_{};
+    Clock::time_point next_frame_time_{};
+    FrameTiming frame_timing_{};
     uint32_t current_image_index_{};
     bool is_frame_started_{false};
 };
\ No newline at end of file
@@ -6,17 +6,77 @@
  * @date 2023-04-28
  */
 
+#include <array>
 #include <memory>
+#include <vector>
 
+#include "BVulkanCullSystem.h"
+#include "BVulkanFrustumCuller.h"
 #include "BVulkanHeader.h"
 #include "BVulkanModel.h"
+#include "BVulkanPipelineRegistry.h"
+#include "BVulkanRingBuffer.h"
 
 class BVulkanDevice;
+class BVulkanFrameContext;
+class BVulkanImage;
 class BVulkanPipeline;
 
 class BVulkanRenderSystem {
 public:
-    BVulkanRenderSystem(BVulkanDevice* device, const vk::RenderPass& render_pass);
+    struct RenderObject {
+        const BVulkanModel* model_{};
+        glm::mat4 transform_{1.0F};
+        glm::vec4 color_{1.0F};
+    };
+
+    struct PushConstantData {
+        glm::mat4 view_projection_{1.0F};
+    };
+
+    struct FrameData {
+        glm::vec4 direction_to_light_{glm::normalize(glm::vec3(1.0F, -3.0F, -1.0F)), 0.0F};
+        glm::vec4 light_color_{1.0F};
+        glm::vec4 ambient_color_{0.0F};
+    };
+
+    struct VertexSpecialization {
+        vk::Bool32 octahedral_normal_{VK_FALSE};
+    };
+
+    struct FragmentSpecialization {
+        vk::Bool32 alpha_test_{VK_FALSE};
+        float alpha_cutoff_{0.5F};
+    };
+
+    struct RasterState {
+        vk::CullModeFlags cull_mode_{vk::CullModeFlagBits::eNone};
+        vk::FrontFace front_face_{vk::FrontFace::eClockwise};
+        bool depth_test_{true};
+        bool depth_write_{true};
+        vk::CompareOp depth_compare_op_{vk::CompareOp::eLess};
+    };
+
+    enum class DrawMode {
+        eDirect,
+        eIndirect,
+    };
+
+    enum class CullMode {
+        eNone,
+        eFrustum,
+        eFrustumOcclusion,
+    };
+
+    struct Batch {
+        BVulkanPipeline* pipeline_{};
+        const BVulkanModel* model_{};
+        uint32_t first_{0};
+        uint32_t count_{0};
+    };
+
+public:
+    BVulkanRenderSystem(BVulkanDevice* device, const vk::RenderPass& render_pass, vk::Format color_format, vk::Format depth_format, size_t frame_count);
     ~BVulkanRenderSystem();
     BVulkanRenderSystem(const BVulkanRenderSystem& system) = delete;
     BVulkanRenderSystem(BVulkanRenderSystem&& system) = delete;
@@ -24,14 +84,63 @@ public:
     BVulkanRenderSystem& operator=(BVulkanRenderSystem&& system) = delete;
 
 public:
-    void RenderObjects(vk::CommandBuffer& command_buffer, const std::vector<BVulkanModel>& models);
+    void BeginFrame(BVulkanFrameContext& frame);
+    void SetViewProjection(const glm::mat4& view_projection);
+    void SetLight(const glm::vec3& direction_to_light, const glm::vec3& light_color, const glm::vec3& ambient_color);
+    void SetDrawMode(DrawMode draw_mode);
+    void SetCullMode(CullMode cull_mode);
+    bool UsesDepthPyramid() const;
+    void SetAlphaTest(bool alpha_test, float alpha_cutoff = 0.5F);
+    void SetRasterState(const RasterState& raster_state);
+    void SetAttachmentFormats(const vk::RenderPass& render_pass, vk::Format color_format, vk::Format depth_format);
+    void PrepareObjects(vk::CommandBuffer& command_buffer, const std::vector<RenderObject>& objects);
+    void RenderObjects(vk::CommandBuffer& command_buffer);
+    void BuildDepthPyramid(vk::CommandBuffer& command_buffer, const BVulkanImage& depth_image, const vk::Extent2D& depth_extent);
 
 private:
     void CreatePipelineLayout();
-    std::unique_ptr<BVulkanPipeline> CreatePipeline(const std::string& vert_shader_path, const std::string& frag_shader_path, vk::PrimitiveTopology primitive_topology, const vk::RenderPass& render_pass);
+    void BindFrameData(vk::CommandBuffer& command_buffer);
+    BVulkanPipelineRegistry::Handle CreatePipeline(vk::PrimitiveTopology primitive_topology, BVulkanModel::VertexFormat vertex_format, const BVulkanPipelineRegistry::Handle& fallback = {});
+    BVulkanPipeline* GetPipeline(BVulkanModel::VertexFormat vertex_format);
+    void ResetPipelines(bool compatible = true);
+    void SetDynamicState(vk::CommandBuffer& command_buffer) const;
+    void SyncFrustumCuller(const std::vector<RenderObject>& objects);
+    void DrawBatch(vk::CommandBuffer& command_buffer, const Batch& batch) const;
+
+public:
+    static constexpr size_t VERTEX_FORMAT_COUNT{3};
+    static constexpr uint32_t VERTEX_CONSTANT_ID{0};
+    static constexpr uint32_t FRAGMENT_CONSTANT_ID{1};
+    static constexpr uint32_t FRAME_DATA_SET{0};
+    static constexpr uint32_t FRAME_DATA_BINDING{0};
 
 private:
     BVulkanDevice* device_;
+    vk::RenderPass render_pass_{};
+    vk::Format color_format_{};
+    vk::Format depth_format_{};
     vk::PipelineLayout pipeline_layout_{};
-    std::unique_ptr<BVulkanPipeline> pipeline_{};
+    vk::ShaderStageFlags push_constant_stages_{};
+    vk::DescriptorSetLayout frame_set_layout_{};
+    BVulkanFrameContext* frame_{};
+    FrameData frame_data_{};
+    std::array<BVulkanPipelineRegistry::Handle, VERTEX_FORMAT_COUNT> pipelines_{};
+    FragmentSpecialization fragment_specialization_{};
+    RasterState raster_state_{};
+    std::unique_ptr<BVulkanCullSystem> cull_system_{};
+    std::unique_ptr<BVulkanFrustumCuller> frustum_culler_{};
+    bool multi_draw_indirect_{false};
+    bool culling_{false};
+    DrawMode draw_mode_{DrawMode::eIndirect};
+    CullMode cull_mode_{CullMode::eFrustum};
+    glm::mat4 view_projection_{1.0F};
+    std::vector<const RenderObject*> sorted_objects_{};
+    std::vector<Batch> batches_{};
+    std::vector<BVulkanCullSystem::CullObject> cull_objects_{};
+    std::vector<uint32_t> culler_handles_{};
+    std::vector<uint32_t> culler_objects_{};
+    std::vector<const BVulkanModel*> culler_models_{};
+    std::vector<uint32_t> visible_objects_{};
+    BVulkanRingBuffer::Allocation instances_{};
+    BVulkanRingBuffer::Allocation commands_{};
 };
\ No newline at end of file
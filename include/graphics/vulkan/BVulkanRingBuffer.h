@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * @file BVulkanRingBuffer.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-13
+ */
+
+#include <cstddef>
+
+#include "BVulkanBuffer.h"
+#include "BVulkanHeader.h"
+
+class BVulkanDevice;
+
+class BVulkanRingBuffer {
+public:
+    struct Allocation {
+        vk::Buffer buffer_{};
+        vk::DeviceSize offset_{0};
+        void* mapped_{nullptr};
+    };
+
+public:
+    BVulkanRingBuffer(BVulkanDevice* device, vk::DeviceSize frame_size, vk::BufferUsageFlags usage, size_t frame_count);
+    ~BVulkanRingBuffer() = default;
+    BVulkanRingBuffer(const BVulkanRingBuffer& ring) = delete;
+    BVulkanRingBuffer(BVulkanRingBuffer&& ring) = delete;
+    BVulkanRingBuffer& operator=(const BVulkanRingBuffer& ring) = delete;
+    BVulkanRingBuffer& operator=(BVulkanRingBuffer&& ring) = delete;
+
+public:
+    void BeginFrame(size_t frame_index);
+    Allocation Allocate(vk::DeviceSize size, vk::DeviceSize alignment = DEFAULT_ALIGNMENT);
+    const vk::Buffer& Buffer() const;
+
+private:
+    void Grow(vk::DeviceSize minimum_frame_size);
+
+public:
+    static constexpr vk::DeviceSize DEFAULT_ALIGNMENT{16};
+    static constexpr vk::DeviceSize FRAME_ALIGNMENT{256};
+
+private:
+    BVulkanDevice* device_{};
+    vk::BufferUsageFlags usage_{};
+    size_t frame_count_{0};
+    vk::DeviceSize frame_size_{0};
+    BVulkanBuffer buffer_{};
+    size_t frame_index_{0};
+    vk::DeviceSize head_{0};
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * @file BVulkanShaderLibrary.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-17
+ */
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BVulkanShaderReflection.h"
+
+class BVulkanShaderLibrary {
+public:
+    BVulkanShaderLibrary();
+    ~BVulkanShaderLibrary() = default;
+    BVulkanShaderLibrary(const BVulkanShaderLibrary& library) = delete;
+    BVulkanShaderLibrary(BVulkanShaderLibrary&& library) = delete;
+    BVulkanShaderLibrary& operator=(const BVulkanShaderLibrary& library) = delete;
+    BVulkanShaderLibrary& operator=(BVulkanShaderLibrary&& library) = delete;
+
+public:
+    std::span<const uint32_t> GetShader(const std::string& name);
+    const BVulkanShaderReflection& GetReflection(const std::string& name);
+    bool HasOverride() const;
+    static std::vector<uint32_t> ReadFile(const std::string& path);
+
+public:
+    static constexpr const char* SHADER_DIRECTORY_VARIABLE{"BT_SHADER_DIR"};
+
+private:
+    std::string override_directory_{};
+    std::mutex mutex_{};
+    std::unordered_map<std::string, std::vector<uint32_t>> overrides_{};
+    std::unordered_map<std::string, std::unique_ptr<BVulkanShaderReflection>> reflections_{};
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+/**
+ * @file BVulkanShaderReflection.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-18
+ */
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "BVulkanHeader.h"
+
+class BVulkanShaderReflection {
+public:
+    enum class BaseType {
+        eFloat,
+        eInt,
+        eUint,
+    };
+
+    struct VertexInput {
+        uint32_t location_{0};
+        BaseType base_type_{BaseType::eFloat};
+        uint32_t component_count_{0};
+    };
+
+    struct DescriptorBinding {
+        uint32_t set_{0};
+        uint32_t binding_{0};
+        vk::DescriptorType type_{};
+        uint32_t count_{1};
+    };
+
+public:
+    explicit BVulkanShaderReflection(std::span<const uint32_t> code);
+    ~BVulkanShaderReflection() = default;
+    BVulkanShaderReflection(const BVulkanShaderReflection& reflection) = delete;
+    BVulkanShaderReflection(BVulkanShaderReflection&& reflection) = delete;
+    BVulkanShaderReflection& operator=(const BVulkanShaderReflection& reflection) = delete;
+    BVulkanShaderReflection& operator=(BVulkanShaderReflection&& reflection) = delete;
+
+public:
+    vk::ShaderStageFlagBits GetStage() const;
+    const std::vector<VertexInput>& GetVertexInputs() const;
+    const std::vector<DescriptorBinding>& GetDescriptorBindings() const;
+    uint32_t GetPushConstantSize() const;
+    void ValidateVertexInput(const std::vector<vk::VertexInputAttributeDescription>& attributes) const;
+
+private:
+    vk::ShaderStageFlagBits stage_{};
+    std::vector<VertexInput> vertex_inputs_{};
+    std::vector<DescriptorBinding> descriptor_bindings_{};
+    uint32_t push_constant_size_{0};
+};
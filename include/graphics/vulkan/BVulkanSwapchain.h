@@ -9,12 +9,21 @@
 #include <vector>
 
 #include "BVulkanHeader.h"
+#include "BVulkanImage.h"
 
 class BVulkanDevice;
 
 class BVulkanSwapchain {
 public:
-    BVulkanSwapchain(BVulkanDevice* device, int width, int height);
+    struct Config {
+        vk::PresentModeKHR present_mode_{vk::PresentModeKHR::eMailbox};
+        uint32_t image_count_{0};
+        size_t frames_in_flight_{0};
+        bool sampled_depth_{false};
+    };
+
+public:
+    BVulkanSwapchain(BVulkanDevice* device, int width, int height, size_t frames_in_flight, const Config& config = {});
     ~BVulkanSwapchain();
     BVulkanSwapchain(const BVulkanSwapchain& swapchain) = delete;
     BVulkanSwapchain(BVulkanSwapchain&& swapchain) = delete;
@@ -25,13 +34,27 @@ public:
     vk::Extent2D GetSwapchainExtent() const;
     size_t GetImageCount() const;
     const vk::RenderPass& GetRenderPass() const;
+    const vk::Format& GetSwapchainImageFormat() const;
+    const vk::Format& GetDepthFormat() const;
+    vk::AttachmentStoreOp GetDepthStoreOp() const;
     float GetExtentAspectRatio() const;
+    vk::PresentModeKHR GetPresentMode() const;
+    const Config& GetConfig() const;
+    void SetConfig(const Config& config);
+    void WaitForFrame() const;
     uint32_t AcquireNextImage();
-    void SubmitCommandBuffers(const vk::CommandBuffer& buffer, uint32_t image_index);
-    const vk::Framebuffer& GetFrameBuffer(size_t index) const;
+    void SubmitCommandBuffers(const vk::CommandBuffer& buffer, uint32_t image_index, const std::vector<vk::Semaphore>& wait_semaphores, const std::vector<uint64_t>& wait_values, const std::vector<vk::PipelineStageFlags>& wait_stages);
+    size_t GetCurrentFrame() const;
+    const vk::Framebuffer& GetFrameBuffer(size_t image_index, size_t frame_index) const;
+    const vk::Image& GetSwapchainImage(size_t index) const;
+    const vk::ImageView& GetSwapchainImageView(size_t index) const;
+    const BVulkanImage& GetDepthImage(size_t frame_index) const;
+    void Recreate(int width, int height);
+    void RecreateDepthResources();
 
 private:
-    void CreateSwapchain();
+    void CreateSwapchain(vk::SwapchainKHR old_swapchain = nullptr);
+    void RetireSwapchain();
     void CreateRenderPass();
     void CreateDepthResources();
     void CreateFrameBuffers();
@@ -39,30 +62,31 @@ private:
 
 private:
     static vk::SurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& available_formats);
-    static vk::PresentModeKHR ChooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& available_present_modes);
+    static vk::PresentModeKHR ChooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& available_present_modes, vk::PresentModeKHR preferred_present_mode);
+    uint32_t ChooseImageCount(const vk::SurfaceCapabilitiesKHR& capabilities) const;
     vk::Extent2D ChooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities);
     vk::Format FindDepthFormat() const;
-    const vk::Format& GetSwapchainImageFormat() const;
 
 public:
-    static constexpr int MAX_FRAMES_IN_FLIGHT{2};
+    static constexpr uint32_t DEPTH_EXTENT_ALIGNMENT{128};
 
 private:
     BVulkanDevice* device_{};
     vk::Extent2D canvas_extent_{};
+    size_t frames_in_flight_{0};
+    Config config_{};
+    vk::PresentModeKHR present_mode_{};
     vk::Format swapchain_image_format_{};
+    vk::Format depth_format_{};
+    bool depth_sampled_{false};
     vk::Extent2D swapchain_extent_{};
     vk::SwapchainKHR swapchain_{};
     std::vector<vk::Image> swapchain_images_{};
     std::vector<vk::ImageView> swapchain_image_views_{};
     vk::RenderPass render_pass_{};
-    std::vector<vk::Image> depth_images_{};
-    std::vector<vk::DeviceMemory> depth_image_memories_{};
-    std::vector<vk::ImageView> depth_image_views_{};
+    std::vector<BVulkanImage> depth_images_{};
     std::vector<vk::Framebuffer> swapchain_frame_buffers_{};
     std::vector<vk::Semaphore> image_available_semaphores_{};
     std::vector<vk::Semaphore> render_finished_semaphores_{};
-    std::vector<vk::Fence> in_flight_fences_{};
-    std::vector<vk::Fence> images_in_flight_{};
     size_t current_frame_{0};
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * @file BVulkanThreadPool.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-16
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class BVulkanThreadPool {
+public:
+    explicit BVulkanThreadPool(size_t thread_count);
+    ~BVulkanThreadPool();
+    BVulkanThreadPool(const BVulkanThreadPool& pool) = delete;
+    BVulkanThreadPool(BVulkanThreadPool&& pool) = delete;
+    BVulkanThreadPool& operator=(const BVulkanThreadPool& pool) = delete;
+    BVulkanThreadPool& operator=(BVulkanThreadPool&& pool) = delete;
+
+public:
+    void Submit(std::function<void()>&& task);
+    size_t ThreadCount() const;
+
+private:
+    void Run();
+
+private:
+    std::vector<std::thread> threads_{};
+    std::deque<std::function<void()>> tasks_{};
+    std::mutex mutex_{};
+    std::condition_variable condition_{};
+    bool stopping_{false};
+};
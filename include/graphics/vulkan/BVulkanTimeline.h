@@ -0,0 +1,38 @@
+#pragma once
+
+/**
+ * @file BVulkanTimeline.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-21
+ */
+
+#include <cstdint>
+
+#include "BVulkanHeader.h"
+
+class BVulkanDevice;
+
+class BVulkanTimeline {
+public:
+    explicit BVulkanTimeline(BVulkanDevice* device);
+    ~BVulkanTimeline();
+    BVulkanTimeline(const BVulkanTimeline& timeline) = delete;
+    BVulkanTimeline(BVulkanTimeline&& timeline) = delete;
+    BVulkanTimeline& operator=(const BVulkanTimeline& timeline) = delete;
+    BVulkanTimeline& operator=(BVulkanTimeline&& timeline) = delete;
+
+public:
+    const vk::Semaphore& Semaphore() const;
+    uint64_t GetSubmittedValue() const;
+    uint64_t GetPendingValue() const;
+    uint64_t GetCompletedValue() const;
+    uint64_t Advance();
+    bool IsComplete(uint64_t value) const;
+    void Wait(uint64_t value) const;
+
+private:
+    BVulkanDevice* device_;
+    vk::Semaphore semaphore_{};
+    uint64_t submitted_value_{0};
+    mutable uint64_t completed_value_{0};
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ * @file BVulkanUploader.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-07
+ */
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "BVulkanAllocator.h"
+#include "BVulkanHeader.h"
+
+class BVulkanDevice;
+class BVulkanTimeline;
+
+class BVulkanUploader {
+public:
+    BVulkanUploader(BVulkanDevice* device, vk::DeviceSize capacity = DEFAULT_CAPACITY);
+    ~BVulkanUploader();
+    BVulkanUploader(const BVulkanUploader& uploader) = delete;
+    BVulkanUploader(BVulkanUploader&& uploader) = delete;
+    BVulkanUploader& operator=(const BVulkanUploader& uploader) = delete;
+    BVulkanUploader& operator=(BVulkanUploader&& uploader) = delete;
+
+public:
+    void UploadBuffer(const void* data, vk::DeviceSize size, const vk::Buffer& dst, vk::DeviceSize dst_offset = 0);
+    void UploadImage(const void* data, vk::DeviceSize size, const vk::Image& dst, vk::Extent3D extent, vk::ImageAspectFlags aspect, vk::ImageLayout final_layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+    void Flush();
+    void WaitIdle();
+    void RecordAcquires(const vk::CommandBuffer& command_buffer, std::vector<vk::Semaphore>& wait_semaphores, std::vector<uint64_t>& wait_values, std::vector<vk::PipelineStageFlags>& wait_stages);
+    bool HasDedicatedTransferQueue() const;
+    uint64_t GetRecordedValue() const;
+    bool IsComplete(uint64_t value) const;
+
+private:
+    struct Batch {
+        vk::CommandBuffer command_buffer_{};
+        uint64_t value_{0};
+        vk::DeviceSize bytes_{0};
+        std::vector<vk::BufferMemoryBarrier> buffer_releases_{};
+        std::vector<vk::ImageMemoryBarrier> image_releases_{};
+        std::vector<vk::BufferMemoryBarrier> buffer_returns_{};
+    };
+
+private:
+    vk::DeviceSize Reserve(vk::DeviceSize size, vk::DeviceSize alignment);
+    vk::CommandBuffer GetRecordingCommandBuffer();
+    void ReclaimBuffer(const vk::CommandBuffer& command_buffer, const vk::Buffer& buffer);
+    uint64_t SubmitReturns();
+    void Retire(bool wait);
+
+public:
+    static constexpr vk::DeviceSize DEFAULT_CAPACITY{32ULL * 1024 * 1024};
+    static constexpr vk::DeviceSize COPY_ALIGNMENT{16};
+
+private:
+    BVulkanDevice* device_{};
+    vk::Queue queue_{};
+    uint32_t transfer_family_{0};
+    uint32_t graphics_family_{0};
+    bool dedicated_transfer_{false};
+    vk::Buffer ring_buffer_{};
+    BVulkanAllocator::Allocation ring_allocation_{};
+    vk::DeviceSize capacity_{0};
+    vk::DeviceSize head_{0};
+    vk::DeviceSize used_{0};
+    vk::CommandPool command_pool_{};
+    Batch recording_{};
+    std::deque<Batch> in_flight_{};
+    std::vector<vk::CommandBuffer> free_command_buffers_{};
+    std::unique_ptr<BVulkanTimeline> timeline_{};
+    vk::CommandPool return_pool_{};
+    std::deque<Batch> returns_in_flight_{};
+    std::vector<vk::CommandBuffer> free_return_buffers_{};
+    std::unique_ptr<BVulkanTimeline> return_timeline_{};
+    std::unordered_set<VkBuffer> graphics_owned_{};
+    std::vector<vk::BufferMemoryBarrier> buffer_acquires_{};
+    std::vector<vk::ImageMemoryBarrier> image_acquires_{};
+    uint64_t acquire_value_{0};
+};
@@ -1,13 +1,14 @@
 #version 450
 
-layout(location = 0) in vec3 frag_color;
-layout(location = 0) out vec4 outColor;
+layout(constant_id = 1) const bool ALPHA_TEST = false;
+layout(constant_id = 2) const float ALPHA_CUTOFF = 0.5;
 
-layout(push_constant) uniform Push {
-    mat4 transform; // projection * view * model
-    mat4 normal;
-} push;
+layout(location = 0) in vec4 frag_color;
+layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(frag_color, 1.0);
-}
\ No newline at end of file
+    if (ALPHA_TEST && frag_color.a < ALPHA_CUTOFF) {
+        discard;
+    }
+    outColor = vec4(frag_color.rgb, 1.0);
+}
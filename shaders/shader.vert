@@ -1,22 +1,42 @@
 #version 450
 
+layout(constant_id = 0) const bool OCTAHEDRAL_NORMAL = false;
+
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
+layout(location = 1) in vec4 color;
 layout(location = 2) in vec3 normal;
-layout(location = 3) in vec2 uv;
+layout(location = 4) in mat4 instance_transform;
+layout(location = 8) in vec4 instance_color;
+layout(location = 9) in vec4 dequantization_scale;
+layout(location = 10) in vec4 dequantization_offset;
+layout(location = 11) in mat3 instance_normal_matrix;
 
-layout(location = 0) out vec3 frag_color;
+layout(location = 0) out vec4 frag_color;
 
 layout(push_constant) uniform Push {
-    mat4 transform; // projection * view * model
-    mat4 normal;
+    mat4 view_projection;
 } push;
 
-const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, -3.0, -1.0));
+layout(set = 0, binding = 0) uniform FrameData {
+    vec4 direction_to_light;
+    vec4 light_color;
+    vec4 ambient_color;
+} frame;
+
+vec3 DecodeOctahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = push.transform * vec4(position, 1.0);
-    vec3 normalWorldSpace = normalize(mat3(push.normal) * normal);
-    float lightIntensity = max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
-    frag_color = lightIntensity * color;
-}
\ No newline at end of file
+    vec3 local_position = position * dequantization_scale.xyz + dequantization_offset.xyz;
+    gl_Position = push.view_projection * instance_transform * vec4(local_position, 1.0);
+    vec3 local_normal = OCTAHEDRAL_NORMAL ? DecodeOctahedral(normal.xy) : normal;
+    vec3 normalWorldSpace = normalize(instance_normal_matrix * local_normal);
+    float lightIntensity = max(dot(normalWorldSpace, frame.direction_to_light.xyz), 0);
+    vec3 lighting = frame.ambient_color.rgb + lightIntensity * frame.light_color.rgb;
+    frag_color = vec4(lighting * color.rgb * instance_color.rgb, color.a * instance_color.a);
+}
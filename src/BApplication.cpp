@@ -22,18 +22,19 @@ BApplication::BApplication() {
     main_canvas_ = new BCanvas();
     main_canvas_->Show();
     device_ = new BVulkanDevice({{}, instance, main_canvas_->GetCanvasID()});
-    render_ = new BVulkanRender(device_, main_canvas_);
-    render_system_ = new BVulkanRenderSystem(device_, render_->GetSwapchainRenderPass());
-
-    if (auto command_buffer = render_->BeginFrame()) {
-        render_->BeginSwapchainRenderPass(command_buffer);
-        render_system_->RenderObjects(command_buffer, models_);
-        render_->EndSwapchainRenderPass(command_buffer);
-        render_->EndFrame();
-    }
+    BVulkanSwapchain::Config swapchain_config{};
+    swapchain_config.sampled_depth_ = CULL_MODE == BVulkanRenderSystem::CullMode::eFrustumOcclusion;
+    render_ = new BVulkanRender(device_, main_canvas_, swapchain_config);
+    render_system_ = new BVulkanRenderSystem(device_, render_->GetSwapchainRenderPass(), render_->GetSwapchainColorFormat(), render_->GetSwapchainDepthFormat(), render_->GetFrameCount());
+    render_system_->SetCullMode(CULL_MODE);
 }
 
 BApplication::~BApplication() {
+    delete render_system_;
+    objects_.clear();
+    models_.clear();
+    delete render_;
+    delete device_;
     if (main_canvas_)
         delete main_canvas_;
 }
@@ -66,10 +67,32 @@ LRESULT BApplication::EventProcess(HWND hwnd, UINT msg, WPARAM w_param, LPARAM l
 int BApplication::Exec() {
 #if defined(_WIN32)
     MSG msg = {};
-    while (GetMessage(&msg, nullptr, 0, 0) > 0) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+    while (msg.message != WM_QUIT) {
+        if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        } else if (main_canvas_->Width() == 0 || main_canvas_->Height() == 0) {
+            WaitMessage();
+        } else {
+            DrawFrame();
+        }
     }
 #endif
     return 0;
 }
+
+void BApplication::DrawFrame() {
+    auto swapchain_config = render_->GetSwapchainConfig();
+    swapchain_config.sampled_depth_ = render_system_->UsesDepthPyramid();
+    render_->SetSwapchainConfig(swapchain_config);
+    if (auto command_buffer = render_->BeginFrame()) {
+        render_system_->SetAttachmentFormats(render_->GetSwapchainRenderPass(), render_->GetSwapchainColorFormat(), render_->GetSwapchainDepthFormat());
+        render_system_->BeginFrame(render_->GetCurrentFrame());
+        render_system_->PrepareObjects(command_buffer, objects_);
+        render_->BeginSwapchainRenderPass(command_buffer);
+        render_system_->RenderObjects(command_buffer);
+        render_->EndSwapchainRenderPass(command_buffer);
+        render_system_->BuildDepthPyramid(command_buffer, render_->GetCurrentDepthImage(), render_->GetSwapchainExtent());
+        render_->EndFrame();
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file BVulkanAllocator.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-06
+ */
+
+#include "BVulkanAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+BVulkanAllocator::BVulkanAllocator(vk::PhysicalDevice physical, vk::Device device) : physical_(physical), device_(device) {
+    memory_properties_ = physical_.getMemoryProperties();
+    buffer_image_granularity_ = (std::max)(physical_.getProperties().limits.bufferImageGranularity, vk::DeviceSize{1});
+    pools_.resize(memory_properties_.memoryTypeCount * 2);
+    for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+        pools_[i * 2].memory_type_ = i;
+        pools_[i * 2].block_size_ = PreferredBlockSize(i);
+        pools_[i * 2 + 1].memory_type_ = i;
+        pools_[i * 2 + 1].block_size_ = PreferredBlockSize(i);
+    }
+}
+
+BVulkanAllocator::~BVulkanAllocator() {
+    for (auto& pool : pools_) {
+        for (auto& block : pool.blocks_) {
+            device_.freeMemory(block->memory_);
+        }
+        pool.blocks_.clear();
+    }
+}
+
+BVulkanAllocator::Allocation BVulkanAllocator::Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool linear) {
+    if (properties & vk::MemoryPropertyFlagBits::eLazilyAllocated) {
+        uint32_t memory_type{0};
+        if (!TryFindMemoryType(requirements.memoryTypeBits, properties, memory_type)) {
+            memory_type = FindMemoryType(requirements.memoryTypeBits, properties & ~vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eLazilyAllocated));
+        }
+        return AllocateDedicated(requirements, memory_type);
+    }
+    auto memory_type = FindMemoryType(requirements.memoryTypeBits, properties);
+    auto pool_index = PoolIndex(memory_type, linear);
+    auto& pool = pools_[pool_index];
+    if (requirements.size > pool.block_size_ / 2) {
+        return AllocateDedicated(requirements, memory_type);
+    }
+    Allocation allocation{};
+    allocation.pool_ = pool_index;
+    for (auto& block : pool.blocks_) {
+        if (AllocateFromBlock(*block, requirements, allocation)) {
+            return allocation;
+        }
+    }
+    pool.blocks_.push_back(CreateBlock(memory_type, pool.block_size_));
+    if (!AllocateFromBlock(*pool.blocks_.back(), requirements, allocation)) {
+        throw std::runtime_error("Failed to sub-allocate device memory.");
+    }
+    return allocation;
+}
+
+void BVulkanAllocator::Free(Allocation& allocation) {
+    if (!allocation) {
+        return;
+    }
+    if (allocation.dedicated_) {
+        device_.freeMemory(allocation.memory_);
+        allocation = {};
+        return;
+    }
+    auto& pool = pools_[allocation.pool_];
+    auto it = std::find_if(pool.blocks_.begin(), pool.blocks_.end(), [&allocation](const auto& block) {
+        return block->memory_ == allocation.memory_;
+    });
+    if (it == pool.blocks_.end()) {
+        throw std::runtime_error("Freeing memory that does not belong to the allocator.");
+    }
+    (*it)->ranges_.Free(allocation.offset_, allocation.size_);
+    if ((*it)->ranges_.Used() == 0 && pool.blocks_.size() > 1) {
+        device_.freeMemory((*it)->memory_);
+        pool.blocks_.erase(it);
+    }
+    allocation = {};
+}
+
+uint32_t BVulkanAllocator::FindMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) const {
+    uint32_t memory_type{0};
+    if (!TryFindMemoryType(type_filter, properties, memory_type)) {
+        throw std::runtime_error("Failed to find suitable memory type.");
+    }
+    return memory_type;
+}
+
+bool BVulkanAllocator::TryFindMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties, uint32_t& memory_type) const {
+    for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+        if ((type_filter & (1 << i)) && (memory_properties_.memoryTypes[i].propertyFlags & properties) == properties) {
+            memory_type = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+BVulkanAllocator::Allocation BVulkanAllocator::AllocateDedicated(const vk::MemoryRequirements& requirements, uint32_t memory_type) {
+    vk::MemoryAllocateInfo allocate_info{};
+    allocate_info
+        .setAllocationSize(requirements.size)
+        .setMemoryTypeIndex(memory_type);
+    Allocation allocation{};
+    allocation.memory_ = device_.allocateMemory(allocate_info);
+    allocation.offset_ = 0;
+    allocation.size_ = requirements.size;
+    allocation.mapped_ = MapIfHostVisible(allocation.memory_, memory_type);
+    allocation.dedicated_ = true;
+    return allocation;
+}
+
+bool BVulkanAllocator::AllocateFromBlock(Block& block, const vk::MemoryRequirements& requirements, Allocation& allocation) const {
+    vk::DeviceSize offset{0};
+    if (!block.ranges_.Allocate(requirements.size, requirements.alignment, offset)) {
+        return false;
+    }
+    allocation.memory_ = block.memory_;
+    allocation.offset_ = offset;
+    allocation.size_ = requirements.size;
+    allocation.mapped_ = block.mapped_ ? static_cast<char*>(block.mapped_) + offset : nullptr;
+    allocation.dedicated_ = false;
+    return true;
+}
+
+std::unique_ptr<BVulkanAllocator::Block> BVulkanAllocator::CreateBlock(uint32_t memory_type, vk::DeviceSize size) {
+    vk::MemoryAllocateInfo allocate_info{};
+    allocate_info
+        .setAllocationSize(size)
+        .setMemoryTypeIndex(memory_type);
+    auto block = std::make_unique<Block>();
+    block->memory_ = device_.allocateMemory(allocate_info);
+    block->mapped_ = MapIfHostVisible(block->memory_, memory_type);
+    block->ranges_ = BVulkanRangeAllocator(size);
+    return block;
+}
+
+uint32_t BVulkanAllocator::PoolIndex(uint32_t memory_type, bool linear) const {
+    if (buffer_image_granularity_ <= 1) {
+        return memory_type * 2;
+    }
+    return memory_type * 2 + (linear ? 0 : 1);
+}
+
+void* BVulkanAllocator::MapIfHostVisible(vk::DeviceMemory memory, uint32_t memory_type) const {
+    if (memory_properties_.memoryTypes[memory_type].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+        return device_.mapMemory(memory, 0, VK_WHOLE_SIZE);
+    }
+    return nullptr;
+}
+
+vk::DeviceSize BVulkanAllocator::PreferredBlockSize(uint32_t memory_type) const {
+    auto heap_size = memory_properties_.memoryHeaps[memory_properties_.memoryTypes[memory_type].heapIndex].size;
+    if (heap_size <= 1024ULL * 1024 * 1024) {
+        return AlignUp(heap_size / 8, 1024);
+    }
+    return DEFAULT_BLOCK_SIZE;
+}
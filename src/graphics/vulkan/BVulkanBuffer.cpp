@@ -0,0 +1,61 @@
+/**
+ * @file BVulkanBuffer.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-08
+ */
+
+#include "BVulkanBuffer.h"
+
+#include <utility>
+
+#include "BVulkanDevice.h"
+
+BVulkanBuffer::BVulkanBuffer(BVulkanDevice* device, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties) : device_(device), size_(size) {
+    device_->CreateBuffer(size_, usage, properties, buffer_, allocation_);
+}
+
+BVulkanBuffer::~BVulkanBuffer() {
+    Release();
+}
+
+BVulkanBuffer::BVulkanBuffer(BVulkanBuffer&& buffer) noexcept
+    : device_(std::exchange(buffer.device_, nullptr)),
+      buffer_(std::exchange(buffer.buffer_, nullptr)),
+      allocation_(std::exchange(buffer.allocation_, {})),
+      size_(std::exchange(buffer.size_, 0)) {
+}
+
+BVulkanBuffer& BVulkanBuffer::operator=(BVulkanBuffer&& buffer) noexcept {
+    if (this != &buffer) {
+        Release();
+        device_ = std::exchange(buffer.device_, nullptr);
+        buffer_ = std::exchange(buffer.buffer_, nullptr);
+        allocation_ = std::exchange(buffer.allocation_, {});
+        size_ = std::exchange(buffer.size_, 0);
+    }
+    return *this;
+}
+
+const vk::Buffer& BVulkanBuffer::Buffer() const {
+    return buffer_;
+}
+
+vk::DeviceSize BVulkanBuffer::Size() const {
+    return size_;
+}
+
+void* BVulkanBuffer::Mapped() const {
+    return allocation_.mapped_;
+}
+
+void BVulkanBuffer::Release() {
+    if (!buffer_) {
+        return;
+    }
+    device_->GetDeletionQueue().Push([device = device_, buffer = buffer_, allocation = allocation_]() mutable {
+        device->DestroyBuffer(buffer, allocation);
+    });
+    buffer_ = nullptr;
+    allocation_ = {};
+    size_ = 0;
+}
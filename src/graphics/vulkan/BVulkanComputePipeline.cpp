@@ -0,0 +1,50 @@
+/**
+ * @file BVulkanComputePipeline.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-14
+ */
+
+#include "BVulkanComputePipeline.h"
+
+#include <chrono>
+
+#include "BVulkanDevice.h"
+
+BVulkanComputePipeline::BVulkanComputePipeline(BVulkanDevice* device, std::span<const uint32_t> comp_shader_code, const vk::PipelineLayout& pipeline_layout) : device_(device) {
+    CreateComputePipeline(comp_shader_code, pipeline_layout);
+}
+
+BVulkanComputePipeline::~BVulkanComputePipeline() {
+    device_->Device().destroyShaderModule(comp_shader_module_);
+    device_->Device().destroyPipeline(compute_pipeline_);
+}
+
+void BVulkanComputePipeline::Bind(const vk::CommandBuffer& buffer) {
+    buffer.bindPipeline(vk::PipelineBindPoint::eCompute, compute_pipeline_);
+}
+
+void BVulkanComputePipeline::CreateComputePipeline(std::span<const uint32_t> comp_shader_code, const vk::PipelineLayout& pipeline_layout) {
+    comp_shader_module_ = CreateShaderModule(comp_shader_code);
+    vk::PipelineShaderStageCreateInfo comp_shader_stage_info;
+    comp_shader_stage_info
+        .setStage(vk::ShaderStageFlagBits::eCompute)
+        .setModule(comp_shader_module_)
+        .setPName("main");
+    vk::ComputePipelineCreateInfo pipeline_info;
+    pipeline_info
+        .setStage(comp_shader_stage_info)
+        .setLayout(pipeline_layout)
+        .setBasePipelineIndex(-1)
+        .setBasePipelineHandle(nullptr);
+    auto start = std::chrono::steady_clock::now();
+    compute_pipeline_ = device_->Device().createComputePipeline(device_->GetPipelineCache(), pipeline_info).value;
+    device_->RecordPipelineCreation(std::chrono::steady_clock::now() - start);
+}
+
+vk::ShaderModule BVulkanComputePipeline::CreateShaderModule(std::span<const uint32_t> code) {
+    vk::ShaderModuleCreateInfo create_info{};
+    create_info
+        .setCodeSize(code.size_bytes())
+        .setPCode(code.data());
+    return device_->Device().createShaderModule(create_info);
+}
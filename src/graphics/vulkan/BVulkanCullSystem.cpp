@@ -0,0 +1,316 @@
+/**
+ * @file BVulkanCullSystem.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-14
+ */
+
+#include "BVulkanCullSystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "BVulkanComputePipeline.h"
+#include "BVulkanDevice.h"
+#include "BVulkanFrustumCuller.h"
+#include "BVulkanModel.h"
+#include "BVulkanPipelineLayoutCache.h"
+
+namespace {
+
+uint32_t PreviousPowerOfTwo(uint32_t value) {
+    uint32_t result = 1;
+    while (result * 2 <= value) {
+        result *= 2;
+    }
+    return result;
+}
+
+}  // namespace
+
+BVulkanCullSystem::BVulkanCullSystem(BVulkanDevice* device, size_t frame_count) : device_(device), frame_count_(frame_count) {
+    CreateSampler();
+    CreateCullLayout();
+    CreatePyramidLayout();
+    cull_pipeline_ = std::make_unique<BVulkanComputePipeline>(device_, device_->GetShaderLibrary().GetShader("cull.comp"), cull_pipeline_layout_);
+    pyramid_pipeline_ = std::make_unique<BVulkanComputePipeline>(device_, device_->GetShaderLibrary().GetShader("depth_pyramid.comp"), pyramid_pipeline_layout_);
+    CreateDescriptorSets();
+    object_ring_ = std::make_unique<BVulkanRingBuffer>(device_, DEFAULT_OBJECT_CAPACITY * sizeof(CullObject) + sizeof(CullParams), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eUniformBuffer, frame_count_);
+    for (size_t i = 0; i < frame_count_; ++i) {
+        instance_buffers_.emplace_back(device_, DEFAULT_OBJECT_CAPACITY * sizeof(BVulkanModel::Instance), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+    }
+    CreateDepthPyramid(1, 1);
+}
+
+BVulkanCullSystem::~BVulkanCullSystem() {
+    DestroyDepthPyramid();
+    instance_buffers_.clear();
+    object_ring_.reset();
+    pyramid_pipeline_.reset();
+    cull_pipeline_.reset();
+    device_->Device().destroyDescriptorPool(cull_descriptor_pool_);
+    device_->Device().destroySampler(sampler_);
+}
+
+void BVulkanCullSystem::BeginFrame(size_t frame_index) {
+    frame_index_ = frame_index % frame_count_;
+    object_ring_->BeginFrame(frame_index_);
+}
+
+void BVulkanCullSystem::SetOcclusion(bool occlusion) {
+    occlusion_ = occlusion;
+    if (!occlusion_) {
+        pyramid_valid_ = false;
+    }
+}
+
+void BVulkanCullSystem::Cull(vk::CommandBuffer& command_buffer, const glm::mat4& view_projection, const BVulkanRingBuffer::Allocation& instances, vk::DeviceSize instance_size, const BVulkanRingBuffer::Allocation& commands, vk::DeviceSize command_size, const std::vector<CullObject>& objects) {
+    if (objects.empty()) {
+        return;
+    }
+    auto& visible_instances = instance_buffers_[frame_index_];
+    if (visible_instances.Size() < instance_size) {
+        visible_instances = BVulkanBuffer(device_, (std::max)(instance_size, visible_instances.Size() * 2), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+    }
+
+    if (!pyramid_initialized_) {
+        TransitionDepthPyramid(command_buffer, vk::PipelineStageFlagBits::eTopOfPipe, {}, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead);
+    }
+
+    CullParams params{};
+    params.planes_ = BVulkanFrustumCuller::ExtractFrustumPlanes(view_projection);
+    params.pyramid_view_projection_ = pyramid_view_projection_;
+    params.pyramid_size_ = glm::vec4(static_cast<float>(depth_pyramid_.Extent().width), static_cast<float>(depth_pyramid_.Extent().height), static_cast<float>(depth_pyramid_.MipLevels()), 0.0F);
+    params.object_count_ = static_cast<uint32_t>(objects.size());
+    params.occlusion_ = occlusion_ && pyramid_valid_ ? 1 : 0;
+    auto params_allocation = object_ring_->Allocate(sizeof(CullParams), BVulkanRingBuffer::FRAME_ALIGNMENT);
+    std::memcpy(params_allocation.mapped_, &params, sizeof(CullParams));
+    auto object_allocation = object_ring_->Allocate(sizeof(CullObject) * objects.size(), BVulkanRingBuffer::FRAME_ALIGNMENT);
+    std::memcpy(object_allocation.mapped_, objects.data(), sizeof(CullObject) * objects.size());
+
+    std::array<vk::DescriptorBufferInfo, 5> buffer_infos{
+        vk::DescriptorBufferInfo(params_allocation.buffer_, params_allocation.offset_, sizeof(CullParams)),
+        vk::DescriptorBufferInfo(object_allocation.buffer_, object_allocation.offset_, sizeof(CullObject) * objects.size()),
+        vk::DescriptorBufferInfo(instances.buffer_, instances.offset_, instance_size),
+        vk::DescriptorBufferInfo(commands.buffer_, commands.offset_, command_size),
+        vk::DescriptorBufferInfo(visible_instances.Buffer(), 0, instance_size),
+    };
+    vk::DescriptorImageInfo pyramid_info(sampler_, depth_pyramid_.View(), vk::ImageLayout::eGeneral);
+    std::array<vk::WriteDescriptorSet, 6> writes{};
+    for (uint32_t binding = 0; binding < buffer_infos.size(); ++binding) {
+        writes[binding]
+            .setDstSet(cull_sets_[frame_index_])
+            .setDstBinding(binding)
+            .setDescriptorCount(1)
+            .setDescriptorType(binding == 0 ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer)
+            .setBufferInfo(buffer_infos[binding]);
+    }
+    writes[5]
+        .setDstSet(cull_sets_[frame_index_])
+        .setDstBinding(5)
+        .setDescriptorCount(1)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(pyramid_info);
+    device_->Device().updateDescriptorSets(writes, nullptr);
+
+    cull_pipeline_->Bind(command_buffer);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cull_pipeline_layout_, 0, cull_sets_[frame_index_], nullptr);
+    command_buffer.dispatch((params.object_count_ + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    vk::MemoryBarrier cull_barrier{};
+    cull_barrier
+        .setSrcAccessMask(vk::AccessFlagBits::eShaderWrite)
+        .setDstAccessMask(vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead);
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput, {}, cull_barrier, nullptr, nullptr);
+}
+
+void BVulkanCullSystem::BuildDepthPyramid(vk::CommandBuffer& command_buffer, const BVulkanImage& depth_image, const vk::Extent2D& depth_extent, const glm::mat4& view_projection) {
+    if (!(depth_image.Usage() & vk::ImageUsageFlagBits::eSampled)) {
+        pyramid_valid_ = false;
+        return;
+    }
+    if (depth_extent.width != depth_extent_.width || depth_extent.height != depth_extent_.height) {
+        DestroyDepthPyramid();
+        CreateDepthPyramid(depth_extent.width, depth_extent.height);
+    }
+
+    vk::ImageMemoryBarrier depth_barrier{};
+    depth_barrier
+        .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+        .setOldLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
+        .setNewLayout(vk::ImageLayout::eDepthStencilReadOnlyOptimal)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(depth_image.Image())
+        .setSubresourceRange({depth_image.Aspect(), 0, 1, 0, 1});
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eLateFragmentTests, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, depth_barrier);
+    TransitionDepthPyramid(command_buffer, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite);
+
+    vk::DescriptorImageInfo depth_info(sampler_, depth_image.View(), vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+    vk::WriteDescriptorSet depth_write{};
+    depth_write
+        .setDstSet(pyramid_source_sets_[frame_index_])
+        .setDstBinding(0)
+        .setDescriptorCount(1)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(depth_info);
+    device_->Device().updateDescriptorSets(depth_write, nullptr);
+
+    pyramid_pipeline_->Bind(command_buffer);
+    auto pyramid_extent = depth_pyramid_.Extent();
+    auto source_extent = depth_extent;
+    for (uint32_t mip = 0; mip < depth_pyramid_.MipLevels(); ++mip) {
+        vk::Extent2D destination_extent{(std::max)(pyramid_extent.width >> mip, 1U), (std::max)(pyramid_extent.height >> mip, 1U)};
+        const auto& descriptor_set = mip == 0 ? pyramid_source_sets_[frame_index_] : pyramid_mip_sets_[mip - 1];
+        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pyramid_pipeline_layout_, 0, descriptor_set, nullptr);
+        PyramidPushConstantData push{};
+        push.source_size_ = glm::uvec2(source_extent.width, source_extent.height);
+        push.destination_size_ = glm::uvec2(destination_extent.width, destination_extent.height);
+        command_buffer.pushConstants(pyramid_pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PyramidPushConstantData), &push);
+        command_buffer.dispatch((destination_extent.width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, (destination_extent.height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, 1);
+        TransitionDepthPyramid(command_buffer, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead);
+        source_extent = destination_extent;
+    }
+    pyramid_view_projection_ = view_projection;
+    pyramid_valid_ = true;
+}
+
+const vk::Buffer& BVulkanCullSystem::GetInstanceBuffer() const {
+    return instance_buffers_[frame_index_].Buffer();
+}
+
+void BVulkanCullSystem::CreateSampler() {
+    vk::SamplerCreateInfo sampler_info{};
+    sampler_info
+        .setMagFilter(vk::Filter::eNearest)
+        .setMinFilter(vk::Filter::eNearest)
+        .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+        .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+        .setMinLod(0.0F)
+        .setMaxLod(VK_LOD_CLAMP_NONE);
+    sampler_ = device_->Device().createSampler(sampler_info);
+}
+
+void BVulkanCullSystem::CreateCullLayout() {
+    const auto& layout = device_->GetPipelineLayoutCache().GetLayout({"cull.comp"});
+    cull_set_layout_ = layout.set_layouts_.at(0);
+    cull_pipeline_layout_ = layout.pipeline_layout_;
+}
+
+void BVulkanCullSystem::CreatePyramidLayout() {
+    const auto& layout = device_->GetPipelineLayoutCache().GetLayout({"depth_pyramid.comp"});
+    if (layout.push_constant_size_ < sizeof(PyramidPushConstantData)) {
+        throw std::runtime_error("Shader push constant block is smaller than PyramidPushConstantData.");
+    }
+    pyramid_set_layout_ = layout.set_layouts_.at(0);
+    pyramid_pipeline_layout_ = layout.pipeline_layout_;
+}
+
+void BVulkanCullSystem::CreateDescriptorSets() {
+    auto set_count = static_cast<uint32_t>(frame_count_);
+    std::array<vk::DescriptorPoolSize, 3> pool_sizes{
+        vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, set_count),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, set_count * 4),
+        vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, set_count),
+    };
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info
+        .setMaxSets(set_count)
+        .setPoolSizes(pool_sizes);
+    cull_descriptor_pool_ = device_->Device().createDescriptorPool(pool_info);
+    std::vector<vk::DescriptorSetLayout> layouts(set_count, cull_set_layout_);
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info
+        .setDescriptorPool(cull_descriptor_pool_)
+        .setSetLayouts(layouts);
+    cull_sets_ = device_->Device().allocateDescriptorSets(alloc_info);
+}
+
+void BVulkanCullSystem::CreateDepthPyramid(uint32_t width, uint32_t height) {
+    depth_extent_ = vk::Extent2D{width, height};
+    auto pyramid_width = PreviousPowerOfTwo(width);
+    auto pyramid_height = PreviousPowerOfTwo(height);
+    uint32_t mip_levels = 1;
+    while (((std::max)(pyramid_width, pyramid_height) >> mip_levels) > 0) {
+        ++mip_levels;
+    }
+    depth_pyramid_ = BVulkanImage(device_, pyramid_width, pyramid_height, vk::Format::eR32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::ImageAspectFlagBits::eColor, mip_levels);
+    pyramid_initialized_ = false;
+    pyramid_valid_ = false;
+    auto image = depth_pyramid_.Image();
+    for (uint32_t mip = 0; mip < mip_levels; ++mip) {
+        pyramid_views_.push_back(device_->CreateImageView(image, vk::Format::eR32Sfloat, vk::ImageAspectFlagBits::eColor, mip, 1));
+    }
+
+    auto set_count = static_cast<uint32_t>(frame_count_) + mip_levels - 1;
+    std::array<vk::DescriptorPoolSize, 2> pool_sizes{
+        vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, set_count),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, set_count),
+    };
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info
+        .setMaxSets(set_count)
+        .setPoolSizes(pool_sizes);
+    pyramid_descriptor_pool_ = device_->Device().createDescriptorPool(pool_info);
+    std::vector<vk::DescriptorSetLayout> layouts(set_count, pyramid_set_layout_);
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info
+        .setDescriptorPool(pyramid_descriptor_pool_)
+        .setSetLayouts(layouts);
+    auto sets = device_->Device().allocateDescriptorSets(alloc_info);
+    pyramid_source_sets_.assign(sets.begin(), sets.begin() + static_cast<std::ptrdiff_t>(frame_count_));
+    pyramid_mip_sets_.assign(sets.begin() + static_cast<std::ptrdiff_t>(frame_count_), sets.end());
+
+    std::vector<vk::DescriptorImageInfo> image_infos{};
+    image_infos.reserve(sets.size() * 2);
+    std::vector<vk::WriteDescriptorSet> writes{};
+    for (const auto& descriptor_set : pyramid_source_sets_) {
+        image_infos.emplace_back(nullptr, pyramid_views_[0], vk::ImageLayout::eGeneral);
+        writes.emplace_back(descriptor_set, 1, 0, 1, vk::DescriptorType::eStorageImage, &image_infos.back());
+    }
+    for (uint32_t mip = 1; mip < mip_levels; ++mip) {
+        const auto& descriptor_set = pyramid_mip_sets_[mip - 1];
+        image_infos.emplace_back(sampler_, pyramid_views_[mip - 1], vk::ImageLayout::eGeneral);
+        writes.emplace_back(descriptor_set, 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &image_infos.back());
+        image_infos.emplace_back(nullptr, pyramid_views_[mip], vk::ImageLayout::eGeneral);
+        writes.emplace_back(descriptor_set, 1, 0, 1, vk::DescriptorType::eStorageImage, &image_infos.back());
+    }
+    device_->Device().updateDescriptorSets(writes, nullptr);
+}
+
+void BVulkanCullSystem::DestroyDepthPyramid() {
+    if (!depth_pyramid_) {
+        return;
+    }
+    device_->GetDeletionQueue().Push([device = device_, views = pyramid_views_, pool = pyramid_descriptor_pool_]() {
+        device->Device().destroyDescriptorPool(pool);
+        for (const auto& view : views) {
+            device->Device().destroyImageView(view);
+        }
+    });
+    depth_pyramid_.Release();
+    pyramid_views_.clear();
+    pyramid_descriptor_pool_ = nullptr;
+    pyramid_source_sets_.clear();
+    pyramid_mip_sets_.clear();
+    depth_extent_ = vk::Extent2D{};
+    pyramid_initialized_ = false;
+    pyramid_valid_ = false;
+}
+
+void BVulkanCullSystem::TransitionDepthPyramid(vk::CommandBuffer& command_buffer, vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access) {
+    vk::ImageMemoryBarrier barrier{};
+    barrier
+        .setSrcAccessMask(pyramid_initialized_ ? src_access : vk::AccessFlags{})
+        .setDstAccessMask(dst_access)
+        .setOldLayout(pyramid_initialized_ ? vk::ImageLayout::eGeneral : vk::ImageLayout::eUndefined)
+        .setNewLayout(vk::ImageLayout::eGeneral)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(depth_pyramid_.Image())
+        .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, depth_pyramid_.MipLevels(), 0, 1});
+    command_buffer.pipelineBarrier(pyramid_initialized_ ? src_stage : vk::PipelineStageFlagBits::eTopOfPipe, dst_stage, {}, nullptr, nullptr, barrier);
+    pyramid_initialized_ = true;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file BVulkanDeletionQueue.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-08
+ */
+
+#include "BVulkanDeletionQueue.h"
+
+#include <utility>
+
+#include "BVulkanTimeline.h"
+#include "BVulkanUploader.h"
+
+BVulkanDeletionQueue::BVulkanDeletionQueue(const BVulkanTimeline* timeline, const BVulkanUploader* uploader) : timeline_(timeline), uploader_(uploader) {
+}
+
+BVulkanDeletionQueue::~BVulkanDeletionQueue() {
+    Flush();
+}
+
+void BVulkanDeletionQueue::Push(std::function<void()>&& deleter) {
+    entries_.push_back({timeline_->GetPendingValue(), uploader_->GetRecordedValue(), std::move(deleter)});
+}
+
+void BVulkanDeletionQueue::Collect() {
+    while (!entries_.empty() && timeline_->IsComplete(entries_.front().value_) && uploader_->IsComplete(entries_.front().upload_value_)) {
+        auto deleter = std::move(entries_.front().deleter_);
+        entries_.pop_front();
+        deleter();
+    }
+}
+
+void BVulkanDeletionQueue::Flush() {
+    auto entries = std::move(entries_);
+    entries_.clear();
+    for (auto& entry : entries) {
+        entry.deleter_();
+    }
+}
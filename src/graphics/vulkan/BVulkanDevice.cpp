@@ -6,10 +6,22 @@
 
 #include "BVulkanDevice.h"
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <set>
 #include <string>
 #include <unordered_set>
 
+#include "BVulkanGeometryArena.h"
+#include "BVulkanPipelineLayoutCache.h"
+#include "BVulkanPipelineRegistry.h"
+#include "BVulkanShaderLibrary.h"
+#include "BVulkanTimeline.h"
+#include "BVulkanUploader.h"
+
 #if defined(_WIN32)
 BVulkanDevice::BVulkanDevice(const vk::Win32SurfaceCreateInfoKHR& surface_info) {
     CreateInstance();
@@ -18,14 +30,71 @@ BVulkanDevice::BVulkanDevice(const vk::Win32SurfaceCreateInfoKHR& surface_info)
     PickPhysicalDevice();
     CreateLogicalDevice();
     CreateCommandPool();
+    CreatePipelineCache();
+    frame_timeline_ = std::make_unique<BVulkanTimeline>(this);
+    allocator_ = std::make_unique<BVulkanAllocator>(physical_, device_);
+    uploader_ = std::make_unique<BVulkanUploader>(this);
+    deletion_queue_ = std::make_unique<BVulkanDeletionQueue>(frame_timeline_.get(), uploader_.get());
+    geometry_arena_ = std::make_unique<BVulkanGeometryArena>(this);
+    shader_library_ = std::make_unique<BVulkanShaderLibrary>();
+    pipeline_layout_cache_ = std::make_unique<BVulkanPipelineLayoutCache>(this);
+    pipeline_registry_ = std::make_unique<BVulkanPipelineRegistry>(this);
 }
 #endif
 
+BVulkanDevice::~BVulkanDevice() {
+    device_.waitIdle();
+    pipeline_registry_.reset();
+    pipeline_layout_cache_.reset();
+    shader_library_.reset();
+    SavePipelineCache();
+    deletion_queue_->Flush();
+    geometry_arena_.reset();
+    deletion_queue_.reset();
+    uploader_.reset();
+    allocator_.reset();
+    frame_timeline_.reset();
+}
+
 const vk::Device& BVulkanDevice::Device() const {
     return device_;
 }
 
-void BVulkanDevice::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& memory) {
+const vk::PhysicalDeviceFeatures& BVulkanDevice::GetEnabledFeatures() const {
+    return enabled_features_;
+}
+
+const vk::DispatchLoaderDynamic& BVulkanDevice::GetDispatcher() const {
+    return dispatcher_;
+}
+
+bool BVulkanDevice::HasDynamicRendering() const {
+    return dynamic_rendering_;
+}
+
+bool BVulkanDevice::HasExtendedDynamicState() const {
+    return extended_dynamic_state_;
+}
+
+bool BVulkanDevice::HasGraphicsPipelineLibrary() const {
+    return graphics_pipeline_library_;
+}
+
+const vk::PipelineCache& BVulkanDevice::GetPipelineCache() const {
+    return pipeline_cache_;
+}
+
+const BVulkanDevice::PipelineCacheStatistics& BVulkanDevice::GetPipelineCacheStatistics() const {
+    return pipeline_cache_statistics_;
+}
+
+void BVulkanDevice::RecordPipelineCreation(std::chrono::duration<double, std::milli> creation_time) {
+    std::lock_guard<std::mutex> lock(pipeline_cache_mutex_);
+    ++pipeline_cache_statistics_.pipeline_count_;
+    pipeline_cache_statistics_.creation_time_ += creation_time;
+}
+
+void BVulkanDevice::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, BVulkanAllocator::Allocation& allocation) {
     vk::BufferCreateInfo buffer_info{};
     buffer_info
         .setFlags(vk::BufferCreateFlags())
@@ -34,12 +103,14 @@ void BVulkanDevice::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage
         .setSharingMode(vk::SharingMode::eExclusive);
     buffer = device_.createBuffer(buffer_info);
     auto memory_requirements = device_.getBufferMemoryRequirements(buffer);
-    vk::MemoryAllocateInfo allocate_info;
-    allocate_info
-        .setAllocationSize(memory_requirements.size)
-        .setMemoryTypeIndex(FindMemoryType(memory_requirements.memoryTypeBits, properties));
-    memory = device_.allocateMemory(allocate_info);
-    device_.bindBufferMemory(buffer, memory, 0);
+    allocation = allocator_->Allocate(memory_requirements, properties, true);
+    device_.bindBufferMemory(buffer, allocation.memory_, allocation.offset_);
+}
+
+void BVulkanDevice::DestroyBuffer(vk::Buffer& buffer, BVulkanAllocator::Allocation& allocation) {
+    device_.destroyBuffer(buffer);
+    buffer = nullptr;
+    allocator_->Free(allocation);
 }
 
 void BVulkanDevice::CopyBuffer(const vk::Buffer& src, vk::Buffer& dst, vk::DeviceSize size) {
@@ -62,6 +133,34 @@ const vk::CommandPool& BVulkanDevice::GetCommandPool() const {
     return command_pool_;
 }
 
+BVulkanUploader& BVulkanDevice::GetUploader() const {
+    return *uploader_;
+}
+
+BVulkanDeletionQueue& BVulkanDevice::GetDeletionQueue() const {
+    return *deletion_queue_;
+}
+
+BVulkanTimeline& BVulkanDevice::GetFrameTimeline() const {
+    return *frame_timeline_;
+}
+
+BVulkanGeometryArena& BVulkanDevice::GetGeometryArena() const {
+    return *geometry_arena_;
+}
+
+BVulkanPipelineRegistry& BVulkanDevice::GetPipelineRegistry() const {
+    return *pipeline_registry_;
+}
+
+BVulkanShaderLibrary& BVulkanDevice::GetShaderLibrary() const {
+    return *shader_library_;
+}
+
+BVulkanPipelineLayoutCache& BVulkanDevice::GetPipelineLayoutCache() const {
+    return *pipeline_layout_cache_;
+}
+
 const vk::Queue& BVulkanDevice::GetGraphicsQueue() const {
     return graphics_queue_;
 }
@@ -70,11 +169,15 @@ const vk::Queue& BVulkanDevice::GetPresentQueue() const {
     return present_queue_;
 }
 
+const vk::Queue& BVulkanDevice::GetTransferQueue() const {
+    return transfer_queue_;
+}
+
 const vk::SurfaceKHR& BVulkanDevice::Surface() const {
     return surface_;
 }
 
-vk::ImageView BVulkanDevice::CreateImageView(vk::Image& image, vk::Format format, vk::ImageAspectFlags aspect_flags) {
+vk::ImageView BVulkanDevice::CreateImageView(vk::Image& image, vk::Format format, vk::ImageAspectFlags aspect_flags, uint32_t base_mip_level, uint32_t mip_levels) {
     vk::ImageViewCreateInfo view_info{};
     view_info
         .setImage(image)
@@ -83,8 +186,8 @@ vk::ImageView BVulkanDevice::CreateImageView(vk::Image& image, vk::Format format
 
     view_info.subresourceRange
         .setAspectMask(aspect_flags)
-        .setBaseMipLevel(0)
-        .setLevelCount(1)
+        .setBaseMipLevel(base_mip_level)
+        .setLevelCount(mip_levels)
         .setBaseArrayLayer(0)
         .setLayerCount(1);
     return device_.createImageView(view_info);
@@ -102,11 +205,11 @@ vk::Format BVulkanDevice::FindSupportedFormat(const std::vector<vk::Format>& can
     throw std::runtime_error("No supported format found.");
 }
 
-void BVulkanDevice::CreateImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& memory) {
+void BVulkanDevice::CreateImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, BVulkanAllocator::Allocation& allocation, uint32_t mip_levels) {
     vk::ImageCreateInfo image_info{};
     image_info
         .setImageType(vk::ImageType::e2D)
-        .setMipLevels(1)
+        .setMipLevels(mip_levels)
         .setArrayLayers(1)
         .setFormat(format)
         .setTiling(tiling)
@@ -120,12 +223,14 @@ void BVulkanDevice::CreateImage(uint32_t width, uint32_t height, vk::Format form
         .setDepth(1);
     image = device_.createImage(image_info);
     auto memory_requirements = device_.getImageMemoryRequirements(image);
-    vk::MemoryAllocateInfo allocate_info{};
-    allocate_info
-        .setAllocationSize(memory_requirements.size)
-        .setMemoryTypeIndex(FindMemoryType(memory_requirements.memoryTypeBits, properties));
-    memory = device_.allocateMemory(allocate_info);
-    device_.bindImageMemory(image, memory, 0);
+    allocation = allocator_->Allocate(memory_requirements, properties, tiling == vk::ImageTiling::eLinear);
+    device_.bindImageMemory(image, allocation.memory_, allocation.offset_);
+}
+
+void BVulkanDevice::DestroyImage(vk::Image& image, BVulkanAllocator::Allocation& allocation) {
+    device_.destroyImage(image);
+    image = nullptr;
+    allocator_->Free(allocation);
 }
 
 void BVulkanDevice::CreateInstance() {
@@ -134,6 +239,7 @@ void BVulkanDevice::CreateInstance() {
     }
     CheckExtensionsSupport();
     vk::ApplicationInfo app_info{};
+    app_info.setApiVersion(VK_API_VERSION_1_3);
     auto extensions = GetRequiredExtensions();
     vk::InstanceCreateInfo create_info{};
     create_info
@@ -179,36 +285,71 @@ void BVulkanDevice::PickPhysicalDevice() {
 void BVulkanDevice::CreateLogicalDevice() {
     auto indices = FindQueueFamilies(physical_);
     auto queue_priority = 1.0F;
+    std::set<uint32_t> unique_families{indices.graphics_family_, indices.present_family_};
+    if (indices.has_transfer_family_) {
+        unique_families.insert(indices.transfer_family_);
+    }
     std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
-    if (indices.graphics_family_ == indices.present_family_) {
+    for (auto family : unique_families) {
         vk::DeviceQueueCreateInfo queue_create_info{};
         queue_create_info
             .setQueueCount(1)
-            .setQueueFamilyIndex(indices.graphics_family_)
-            .setQueuePriorities(queue_priority);
-        queue_create_infos.push_back(queue_create_info);
-    } else {
-        vk::DeviceQueueCreateInfo queue_create_info;
-        queue_create_info
-            .setQueueCount(1)
-            .setQueueFamilyIndex(indices.graphics_family_)
+            .setQueueFamilyIndex(family)
             .setQueuePriorities(queue_priority);
         queue_create_infos.push_back(queue_create_info);
-        queue_create_info.setQueueFamilyIndex(indices.present_family_);
-        queue_create_infos.push_back(queue_create_info);
     }
-    vk::PhysicalDeviceFeatures device_features{};
-    device_features.setSamplerAnisotropy(true);
+    auto supported_features = physical_.getFeatures();
+    enabled_features_
+        .setSamplerAnisotropy(true)
+        .setMultiDrawIndirect(supported_features.multiDrawIndirect)
+        .setDrawIndirectFirstInstance(supported_features.drawIndirectFirstInstance);
+    auto extensions = device_extensions_;
+    auto pipeline_library = false;
+    auto graphics_pipeline_library = false;
+    for (const auto& extension : physical_.enumerateDeviceExtensionProperties()) {
+        std::string extension_name(extension.extensionName.data());
+        if (extension_name == VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) {
+            pipeline_library = true;
+        } else if (extension_name == VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) {
+            graphics_pipeline_library = true;
+        }
+    }
+    vk::PhysicalDeviceVulkan12Features enabled_features_12{};
+    enabled_features_12.setTimelineSemaphore(true);
+    vk::PhysicalDeviceVulkan13Features enabled_features_13{};
+    vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT enabled_library_features{};
+    auto vulkan_13 = physical_.getProperties().apiVersion >= VK_API_VERSION_1_3;
+    if (vulkan_13) {
+        vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features, vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT> supported_features{};
+        if (!pipeline_library || !graphics_pipeline_library) {
+            supported_features.unlink<vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>();
+        }
+        physical_.getFeatures2(&supported_features.get<vk::PhysicalDeviceFeatures2>());
+        dynamic_rendering_ = supported_features.get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering;
+        extended_dynamic_state_ = true;
+        enabled_features_13.setDynamicRendering(dynamic_rendering_);
+        graphics_pipeline_library_ = pipeline_library && graphics_pipeline_library && supported_features.get<vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>().graphicsPipelineLibrary;
+        enabled_features_12.setPNext(&enabled_features_13);
+    }
+    if (graphics_pipeline_library_) {
+        extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        enabled_library_features.setGraphicsPipelineLibrary(true);
+        enabled_features_13.setPNext(&enabled_library_features);
+    }
     vk::DeviceCreateInfo device_create_info{};
     device_create_info
+        .setPNext(&enabled_features_12)
         .setQueueCreateInfoCount(static_cast<uint32_t>(queue_create_infos.size()))
         .setQueueCreateInfos(queue_create_infos)
-        .setEnabledExtensionCount(static_cast<uint32_t>(device_extensions_.size()))
-        .setPEnabledExtensionNames(device_extensions_)
-        .setPEnabledFeatures(&device_features);
+        .setEnabledExtensionCount(static_cast<uint32_t>(extensions.size()))
+        .setPEnabledExtensionNames(extensions)
+        .setPEnabledFeatures(&enabled_features_);
     device_ = physical_.createDevice(device_create_info);
+    dispatcher_ = vk::DispatchLoaderDynamic(instance_, reinterpret_cast<PFN_vkGetInstanceProcAddr>(instance_.getProcAddr("vkGetInstanceProcAddr")), device_);
     graphics_queue_ = device_.getQueue(indices.graphics_family_, 0);
     present_queue_ = device_.getQueue(indices.present_family_, 0);
+    transfer_queue_ = device_.getQueue(indices.has_transfer_family_ ? indices.transfer_family_ : indices.graphics_family_, 0);
 }
 
 void BVulkanDevice::CreateCommandPool() {
@@ -220,6 +361,65 @@ void BVulkanDevice::CreateCommandPool() {
     command_pool_ = device_.createCommandPool(pool_info);
 }
 
+void BVulkanDevice::CreatePipelineCache() {
+    std::vector<char> data{};
+    std::ifstream file(PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary);
+    if (file.is_open()) {
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file || !IsPipelineCacheCompatible(data)) {
+            data.clear();
+        }
+    }
+    vk::PipelineCacheCreateInfo cache_info{};
+    cache_info
+        .setInitialDataSize(data.size())
+        .setPInitialData(data.empty() ? nullptr : data.data());
+    pipeline_cache_ = device_.createPipelineCache(cache_info);
+    pipeline_cache_statistics_.warm_ = !data.empty();
+}
+
+void BVulkanDevice::SavePipelineCache() {
+    if (!pipeline_cache_) {
+        return;
+    }
+#if !defined(NOT_DEBUG)
+    const auto& statistics = pipeline_cache_statistics_;
+    std::cerr << "[INFO] Pipeline cache(" << (statistics.warm_ ? "warm" : "cold") << "): " << statistics.pipeline_count_ << " pipelines created in " << statistics.creation_time_.count() << " ms" << std::endl;
+#endif
+    auto data = device_.getPipelineCacheData(pipeline_cache_);
+    device_.destroyPipelineCache(pipeline_cache_);
+    pipeline_cache_ = nullptr;
+    std::string temporary_path = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            return;
+        }
+    }
+    std::error_code error{};
+    std::filesystem::rename(temporary_path, PIPELINE_CACHE_PATH, error);
+}
+
+bool BVulkanDevice::IsPipelineCacheCompatible(const std::vector<char>& data) const {
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    auto properties = physical_.getProperties();
+    return header.headerSize >= sizeof(header) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+
 bool BVulkanDevice::CheckValidationLayerSupport() const {
     auto available_layers = vk::enumerateInstanceLayerProperties();
     for (const auto& layer_name : validation_layers_) {
@@ -290,7 +490,8 @@ bool BVulkanDevice::IsPhysicalDeviceSuitable(const vk::PhysicalDevice& device) c
         swapchain_adequate = !swapchain_support.formats_.empty() && !swapchain_support.present_modes_.empty();
     }
     auto supported_features = device.getFeatures();
-    return indices && extensions_supported && swapchain_adequate && supported_features.samplerAnisotropy;
+    auto timeline_semaphore = device.getProperties().apiVersion >= VK_API_VERSION_1_2 && device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>().get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore;
+    return indices && extensions_supported && swapchain_adequate && supported_features.samplerAnisotropy && timeline_semaphore;
 }
 
 BVulkanDevice::QueueFamilyIndices BVulkanDevice::FindQueueFamilies(const vk::PhysicalDevice& device) const {
@@ -298,16 +499,22 @@ BVulkanDevice::QueueFamilyIndices BVulkanDevice::FindQueueFamilies(const vk::Phy
     auto properties = device.getQueueFamilyProperties();
     for (size_t i = 0; i < properties.size(); ++i) {
         const auto& property = properties[i];
-        if (property.queueFlags & vk::QueueFlagBits::eGraphics) {
-            indices.graphics_family_ = static_cast<uint32_t>(i);
-            indices.has_graphics_family_ = true;
-        }
-        if (device.getSurfaceSupportKHR(static_cast<uint32_t>(i), surface_)) {
-            indices.present_family_ = static_cast<uint32_t>(i);
-            indices.has_present_family_ = true;
+        if (!indices) {
+            if (property.queueFlags & vk::QueueFlagBits::eGraphics) {
+                indices.graphics_family_ = static_cast<uint32_t>(i);
+                indices.has_graphics_family_ = true;
+            }
+            if (device.getSurfaceSupportKHR(static_cast<uint32_t>(i), surface_)) {
+                indices.present_family_ = static_cast<uint32_t>(i);
+                indices.has_present_family_ = true;
+            }
         }
-        if (indices) {
-            break;
+        if ((property.queueFlags & vk::QueueFlagBits::eTransfer) && !(property.queueFlags & vk::QueueFlagBits::eGraphics)) {
+            auto compute = static_cast<bool>(property.queueFlags & vk::QueueFlagBits::eCompute);
+            if (!indices.has_transfer_family_ || !compute) {
+                indices.transfer_family_ = static_cast<uint32_t>(i);
+                indices.has_transfer_family_ = true;
+            }
         }
     }
     return indices;
@@ -321,17 +528,6 @@ BVulkanDevice::SwapchainSupportDetails BVulkanDevice::QuerySwapchainSupport(cons
     return details;
 }
 
-uint32_t BVulkanDevice::FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) {
-    vk::PhysicalDeviceMemoryProperties memory_properties{};
-    physical_.getMemoryProperties(&memory_properties);
-    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
-        if ((typeFilter & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-    return 0;
-}
-
 vk::CommandBuffer BVulkanDevice::BeginSingleTimeCommands() {
     vk::CommandBufferAllocateInfo allocate_info;
     allocate_info
@@ -351,8 +547,10 @@ void BVulkanDevice::EndSingleTimeCommands(vk::CommandBuffer command_buffer) {
     submit_info
         .setCommandBufferCount(1)
         .setCommandBuffers(command_buffer);
-    graphics_queue_.submit(submit_info);
-    graphics_queue_.waitIdle();
+    auto fence = device_.createFence({});
+    graphics_queue_.submit(submit_info, fence);
+    [[maybe_unused]] auto res = device_.waitForFences(fence, true, (std::numeric_limits<uint64_t>::max)());
+    device_.destroyFence(fence);
     device_.freeCommandBuffers(command_pool_, command_buffer);
 }
 
@@ -0,0 +1,119 @@
+/**
+ * @file BVulkanFrameContext.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-20
+ */
+
+#include "BVulkanFrameContext.h"
+
+#include <array>
+
+#include "BVulkanDevice.h"
+
+BVulkanFrameContext::BVulkanFrameContext(BVulkanDevice* device, size_t index) : device_(device), index_(index) {
+    CreateCommandBuffer();
+    descriptor_pools_.push_back(CreateDescriptorPool());
+    upload_arena_ = std::make_unique<BVulkanRingBuffer>(device_, DEFAULT_UPLOAD_ARENA_SIZE, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, 1);
+    uniform_arena_ = std::make_unique<BVulkanRingBuffer>(device_, DEFAULT_UNIFORM_ARENA_SIZE, vk::BufferUsageFlagBits::eUniformBuffer, 1);
+}
+
+BVulkanFrameContext::~BVulkanFrameContext() {
+    uniform_arena_.reset();
+    upload_arena_.reset();
+    for (auto& descriptor_pool : descriptor_pools_) {
+        device_->Device().destroyDescriptorPool(descriptor_pool);
+    }
+    device_->Device().destroyCommandPool(command_pool_);
+}
+
+size_t BVulkanFrameContext::GetIndex() const {
+    return index_;
+}
+
+vk::CommandBuffer BVulkanFrameContext::Begin() {
+    device_->Device().resetCommandPool(command_pool_);
+    for (auto& descriptor_pool : descriptor_pools_) {
+        device_->Device().resetDescriptorPool(descriptor_pool);
+    }
+    descriptor_pool_index_ = 0;
+    upload_arena_->BeginFrame(0);
+    uniform_arena_->BeginFrame(0);
+    upload_semaphores_.clear();
+    upload_wait_values_.clear();
+    upload_wait_stages_.clear();
+    vk::CommandBufferBeginInfo begin_info{};
+    begin_info.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    command_buffer_.begin(begin_info);
+    return command_buffer_;
+}
+
+const vk::CommandBuffer& BVulkanFrameContext::GetCommandBuffer() const {
+    return command_buffer_;
+}
+
+std::vector<vk::Semaphore>& BVulkanFrameContext::GetUploadSemaphores() {
+    return upload_semaphores_;
+}
+
+std::vector<uint64_t>& BVulkanFrameContext::GetUploadWaitValues() {
+    return upload_wait_values_;
+}
+
+std::vector<vk::PipelineStageFlags>& BVulkanFrameContext::GetUploadWaitStages() {
+    return upload_wait_stages_;
+}
+
+BVulkanRingBuffer& BVulkanFrameContext::GetUploadArena() {
+    return *upload_arena_;
+}
+
+BVulkanRingBuffer& BVulkanFrameContext::GetUniformArena() {
+    return *uniform_arena_;
+}
+
+vk::DescriptorSet BVulkanFrameContext::AllocateDescriptorSet(const vk::DescriptorSetLayout& layout) {
+    while (true) {
+        if (descriptor_pool_index_ == descriptor_pools_.size()) {
+            descriptor_pools_.push_back(CreateDescriptorPool());
+        }
+        vk::DescriptorSetAllocateInfo alloc_info{};
+        alloc_info
+            .setDescriptorPool(descriptor_pools_[descriptor_pool_index_])
+            .setSetLayouts(layout);
+        try {
+            return device_->Device().allocateDescriptorSets(alloc_info).front();
+        } catch ([[maybe_unused]] const vk::OutOfPoolMemoryError& e) {
+            ++descriptor_pool_index_;
+        } catch ([[maybe_unused]] const vk::FragmentedPoolError& e) {
+            ++descriptor_pool_index_;
+        }
+    }
+}
+
+void BVulkanFrameContext::CreateCommandBuffer() {
+    vk::CommandPoolCreateInfo pool_info{};
+    pool_info
+        .setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+        .setQueueFamilyIndex(device_->FindPhysicalQueueFamilies().graphics_family_);
+    command_pool_ = device_->Device().createCommandPool(pool_info);
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info
+        .setLevel(vk::CommandBufferLevel::ePrimary)
+        .setCommandPool(command_pool_)
+        .setCommandBufferCount(1);
+    command_buffer_ = device_->Device().allocateCommandBuffers(alloc_info).front();
+}
+
+vk::DescriptorPool BVulkanFrameContext::CreateDescriptorPool() {
+    std::array<vk::DescriptorPoolSize, 4> pool_sizes{
+        vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, DESCRIPTOR_POOL_SET_COUNT),
+        vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, DESCRIPTOR_POOL_SET_COUNT),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, DESCRIPTOR_POOL_SET_COUNT),
+        vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, DESCRIPTOR_POOL_SET_COUNT),
+    };
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info
+        .setMaxSets(DESCRIPTOR_POOL_SET_COUNT)
+        .setPoolSizes(pool_sizes);
+    return device_->Device().createDescriptorPool(pool_info);
+}
@@ -0,0 +1,345 @@
+/**
+ * @file BVulkanFrustumCuller.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-15
+ */
+
+#include "BVulkanFrustumCuller.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define B_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define B_CULLER_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using Planes = std::array<glm::vec4, 6>;
+
+void TestBoxes4(const Planes& planes, const float* min_x, const float* min_y, const float* min_z, const float* max_x, const float* max_y, const float* max_z, uint32_t& outside, uint32_t& inside) {
+#if defined(B_CULLER_SSE2)
+    auto zero = _mm_setzero_ps();
+    auto outside_mask = zero;
+    auto intersect_mask = zero;
+    for (const auto& plane : planes) {
+        auto nx = _mm_set1_ps(plane.x);
+        auto ny = _mm_set1_ps(plane.y);
+        auto nz = _mm_set1_ps(plane.z);
+        auto d = _mm_set1_ps(plane.w);
+        auto far_x = _mm_loadu_ps(plane.x >= 0.0F ? max_x : min_x);
+        auto far_y = _mm_loadu_ps(plane.y >= 0.0F ? max_y : min_y);
+        auto far_z = _mm_loadu_ps(plane.z >= 0.0F ? max_z : min_z);
+        auto near_x = _mm_loadu_ps(plane.x >= 0.0F ? min_x : max_x);
+        auto near_y = _mm_loadu_ps(plane.y >= 0.0F ? min_y : max_y);
+        auto near_z = _mm_loadu_ps(plane.z >= 0.0F ? min_z : max_z);
+        auto far_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, far_x), _mm_mul_ps(ny, far_y)), _mm_add_ps(_mm_mul_ps(nz, far_z), d));
+        auto near_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, near_x), _mm_mul_ps(ny, near_y)), _mm_add_ps(_mm_mul_ps(nz, near_z), d));
+        outside_mask = _mm_or_ps(outside_mask, _mm_cmplt_ps(far_distance, zero));
+        intersect_mask = _mm_or_ps(intersect_mask, _mm_cmplt_ps(near_distance, zero));
+    }
+    outside = static_cast<uint32_t>(_mm_movemask_ps(outside_mask));
+    inside = ~static_cast<uint32_t>(_mm_movemask_ps(intersect_mask)) & 0xF;
+#else
+    outside = 0;
+    inside = 0xF;
+    for (uint32_t i = 0; i < 4; ++i) {
+        for (const auto& plane : planes) {
+            auto far_distance = plane.x * (plane.x >= 0.0F ? max_x[i] : min_x[i]) + plane.y * (plane.y >= 0.0F ? max_y[i] : min_y[i]) + plane.z * (plane.z >= 0.0F ? max_z[i] : min_z[i]) + plane.w;
+            auto near_distance = plane.x * (plane.x >= 0.0F ? min_x[i] : max_x[i]) + plane.y * (plane.y >= 0.0F ? min_y[i] : max_y[i]) + plane.z * (plane.z >= 0.0F ? min_z[i] : max_z[i]) + plane.w;
+            if (far_distance < 0.0F) {
+                outside |= 1U << i;
+            }
+            if (near_distance < 0.0F) {
+                inside &= ~(1U << i);
+            }
+        }
+    }
+#endif
+}
+
+uint32_t TestBoxes8(const Planes& planes, const float* min_x, const float* min_y, const float* min_z, const float* max_x, const float* max_y, const float* max_z) {
+#if defined(B_CULLER_AVX2)
+    auto zero = _mm256_setzero_ps();
+    auto outside_mask = zero;
+    for (const auto& plane : planes) {
+        auto far_x = _mm256_loadu_ps(plane.x >= 0.0F ? max_x : min_x);
+        auto far_y = _mm256_loadu_ps(plane.y >= 0.0F ? max_y : min_y);
+        auto far_z = _mm256_loadu_ps(plane.z >= 0.0F ? max_z : min_z);
+        auto distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), far_x), _mm256_set1_ps(plane.w));
+        distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.y), far_y), distance);
+        distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), far_z), distance);
+        outside_mask = _mm256_or_ps(outside_mask, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+    }
+    return static_cast<uint32_t>(_mm256_movemask_ps(outside_mask));
+#else
+    uint32_t lower_outside = 0;
+    uint32_t upper_outside = 0;
+    uint32_t inside = 0;
+    TestBoxes4(planes, min_x, min_y, min_z, max_x, max_y, max_z, lower_outside, inside);
+    TestBoxes4(planes, min_x + 4, min_y + 4, min_z + 4, max_x + 4, max_y + 4, max_z + 4, upper_outside, inside);
+    return lower_outside | (upper_outside << 4);
+#endif
+}
+
+}  // namespace
+
+uint32_t BVulkanFrustumCuller::Insert(const glm::vec3& local_min, const glm::vec3& local_max, const glm::mat4& transform) {
+    uint32_t handle{};
+    if (free_handles_.empty()) {
+        handle = static_cast<uint32_t>(local_min_.size());
+        local_min_.emplace_back();
+        local_max_.emplace_back();
+        transforms_.emplace_back();
+        world_min_.emplace_back();
+        world_max_.emplace_back();
+        handle_slot_.emplace_back();
+    } else {
+        handle = free_handles_.back();
+        free_handles_.pop_back();
+    }
+    local_min_[handle] = local_min;
+    local_max_[handle] = local_max;
+    transforms_[handle] = transform;
+    handle_slot_[handle] = 0;
+    ComputeWorldBox(handle);
+    ++size_;
+    needs_build_ = true;
+    return handle;
+}
+
+void BVulkanFrustumCuller::Update(uint32_t handle, const glm::mat4& transform) {
+    transforms_[handle] = transform;
+    ComputeWorldBox(handle);
+    if (needs_build_) {
+        return;
+    }
+    auto slot = handle_slot_[handle];
+    WriteSlot(slot, handle);
+    for (auto node = slot_node_[slot]; node != INVALID_INDEX && !nodes_[node].dirty_; node = nodes_[node].parent_) {
+        nodes_[node].dirty_ = true;
+    }
+    needs_refit_ = true;
+}
+
+void BVulkanFrustumCuller::Remove(uint32_t handle) {
+    handle_slot_[handle] = INVALID_INDEX;
+    free_handles_.push_back(handle);
+    --size_;
+    needs_build_ = true;
+}
+
+void BVulkanFrustumCuller::Clear() {
+    local_min_.clear();
+    local_max_.clear();
+    transforms_.clear();
+    world_min_.clear();
+    world_max_.clear();
+    handle_slot_.clear();
+    free_handles_.clear();
+    size_ = 0;
+    slot_handle_.clear();
+    slot_node_.clear();
+    nodes_.clear();
+    needs_build_ = false;
+    needs_refit_ = false;
+}
+
+size_t BVulkanFrustumCuller::Size() const {
+    return size_;
+}
+
+const glm::mat4& BVulkanFrustumCuller::GetTransform(uint32_t handle) const {
+    return transforms_[handle];
+}
+
+void BVulkanFrustumCuller::Cull(const glm::mat4& view_projection, std::vector<uint32_t>& visible) {
+    visible.clear();
+    if (size_ == 0) {
+        return;
+    }
+    if (needs_build_) {
+        Build();
+    } else if (needs_refit_) {
+        Refit();
+    }
+    auto planes = ExtractFrustumPlanes(view_projection);
+    stack_.clear();
+    stack_.push_back(0);
+    while (!stack_.empty()) {
+        const auto& node = nodes_[stack_.back()];
+        stack_.pop_back();
+        uint32_t outside{0};
+        uint32_t inside{0};
+        TestBoxes4(planes, node.min_x_.data(), node.min_y_.data(), node.min_z_.data(), node.max_x_.data(), node.max_y_.data(), node.max_z_.data(), outside, inside);
+        for (uint32_t i = 0; i < BRANCH_FACTOR; ++i) {
+            auto first = node.first_[i];
+            auto count = node.count_[i];
+            if (count == 0 || (outside >> i) & 1U) {
+                continue;
+            }
+            if ((inside >> i) & 1U) {
+                visible.insert(visible.end(), slot_handle_.begin() + first, slot_handle_.begin() + first + count);
+            } else if (node.child_[i] != INVALID_INDEX) {
+                stack_.push_back(node.child_[i]);
+            } else {
+                auto leaf_outside = TestBoxes8(planes, &min_x_[first], &min_y_[first], &min_z_[first], &max_x_[first], &max_y_[first], &max_z_[first]);
+                for (uint32_t j = 0; j < count; ++j) {
+                    if (((leaf_outside >> j) & 1U) == 0) {
+                        visible.push_back(slot_handle_[first + j]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::array<glm::vec4, 6> BVulkanFrustumCuller::ExtractFrustumPlanes(const glm::mat4& view_projection) {
+    auto row = [&view_projection](int index) {
+        return glm::vec4(view_projection[0][index], view_projection[1][index], view_projection[2][index], view_projection[3][index]);
+    };
+    std::array<glm::vec4, 6> planes{
+        row(3) + row(0),
+        row(3) - row(0),
+        row(3) + row(1),
+        row(3) - row(1),
+        row(2),
+        row(3) - row(2),
+    };
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
+
+void BVulkanFrustumCuller::ComputeWorldBox(uint32_t handle) {
+    const auto& transform = transforms_[handle];
+    auto center = (local_min_[handle] + local_max_[handle]) * 0.5F;
+    auto extent = (local_max_[handle] - local_min_[handle]) * 0.5F;
+    auto world_center = glm::vec3(transform * glm::vec4(center, 1.0F));
+    auto world_extent = glm::abs(glm::vec3(transform[0])) * extent.x + glm::abs(glm::vec3(transform[1])) * extent.y + glm::abs(glm::vec3(transform[2])) * extent.z;
+    world_min_[handle] = world_center - world_extent;
+    world_max_[handle] = world_center + world_extent;
+}
+
+void BVulkanFrustumCuller::Build() {
+    slot_handle_.clear();
+    for (uint32_t handle = 0; handle < handle_slot_.size(); ++handle) {
+        if (handle_slot_[handle] != INVALID_INDEX) {
+            slot_handle_.push_back(handle);
+        }
+    }
+    auto count = static_cast<uint32_t>(slot_handle_.size());
+    slot_node_.assign(count, INVALID_INDEX);
+    nodes_.clear();
+    BuildNode(INVALID_INDEX, 0, count);
+    min_x_.assign(count + LEAF_SIZE, 0.0F);
+    min_y_.assign(count + LEAF_SIZE, 0.0F);
+    min_z_.assign(count + LEAF_SIZE, 0.0F);
+    max_x_.assign(count + LEAF_SIZE, 0.0F);
+    max_y_.assign(count + LEAF_SIZE, 0.0F);
+    max_z_.assign(count + LEAF_SIZE, 0.0F);
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        WriteSlot(slot, slot_handle_[slot]);
+    }
+    needs_build_ = false;
+    Refit();
+}
+
+uint32_t BVulkanFrustumCuller::BuildNode(uint32_t parent, uint32_t begin, uint32_t end) {
+    auto index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[index].parent_ = parent;
+    auto middle = SplitRange(begin, end);
+    std::array<uint32_t, BRANCH_FACTOR + 1> ranges{begin, SplitRange(begin, middle), middle, SplitRange(middle, end), end};
+    for (uint32_t i = 0; i < BRANCH_FACTOR; ++i) {
+        auto first = ranges[i];
+        auto last = ranges[i + 1];
+        nodes_[index].first_[i] = first;
+        nodes_[index].count_[i] = last - first;
+        if (last - first > LEAF_SIZE) {
+            auto child = BuildNode(index, first, last);
+            nodes_[index].child_[i] = child;
+        } else {
+            std::fill(slot_node_.begin() + first, slot_node_.begin() + last, index);
+        }
+    }
+    return index;
+}
+
+uint32_t BVulkanFrustumCuller::SplitRange(uint32_t begin, uint32_t end) {
+    if (end - begin <= LEAF_SIZE) {
+        return end;
+    }
+    glm::vec3 lower{(std::numeric_limits<float>::max)()};
+    glm::vec3 upper{std::numeric_limits<float>::lowest()};
+    for (auto slot = begin; slot < end; ++slot) {
+        auto handle = slot_handle_[slot];
+        auto centroid = world_min_[handle] + world_max_[handle];
+        lower = glm::min(lower, centroid);
+        upper = glm::max(upper, centroid);
+    }
+    auto extent = upper - lower;
+    auto axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    auto middle = begin + (end - begin) / 2;
+    std::nth_element(slot_handle_.begin() + begin, slot_handle_.begin() + middle, slot_handle_.begin() + end, [this, axis](uint32_t lhs, uint32_t rhs) {
+        return world_min_[lhs][axis] + world_max_[lhs][axis] < world_min_[rhs][axis] + world_max_[rhs][axis];
+    });
+    return middle;
+}
+
+void BVulkanFrustumCuller::WriteSlot(uint32_t slot, uint32_t handle) {
+    handle_slot_[handle] = slot;
+    min_x_[slot] = world_min_[handle].x;
+    min_y_[slot] = world_min_[handle].y;
+    min_z_[slot] = world_min_[handle].z;
+    max_x_[slot] = world_max_[handle].x;
+    max_y_[slot] = world_max_[handle].y;
+    max_z_[slot] = world_max_[handle].z;
+}
+
+void BVulkanFrustumCuller::Refit() {
+    for (auto index = nodes_.size(); index-- > 0;) {
+        if (nodes_[index].dirty_) {
+            RefitNode(nodes_[index]);
+            nodes_[index].dirty_ = false;
+        }
+    }
+    needs_refit_ = false;
+}
+
+void BVulkanFrustumCuller::RefitNode(Node& node) {
+    for (uint32_t i = 0; i < BRANCH_FACTOR; ++i) {
+        if (node.count_[i] == 0) {
+            continue;
+        }
+        glm::vec3 lower{(std::numeric_limits<float>::max)()};
+        glm::vec3 upper{std::numeric_limits<float>::lowest()};
+        if (node.child_[i] != INVALID_INDEX) {
+            const auto& child = nodes_[node.child_[i]];
+            for (uint32_t j = 0; j < BRANCH_FACTOR; ++j) {
+                if (child.count_[j] != 0) {
+                    lower = glm::min(lower, glm::vec3(child.min_x_[j], child.min_y_[j], child.min_z_[j]));
+                    upper = glm::max(upper, glm::vec3(child.max_x_[j], child.max_y_[j], child.max_z_[j]));
+                }
+            }
+        } else {
+            for (auto slot = node.first_[i]; slot < node.first_[i] + node.count_[i]; ++slot) {
+                lower = glm::min(lower, glm::vec3(min_x_[slot], min_y_[slot], min_z_[slot]));
+                upper = glm::max(upper, glm::vec3(max_x_[slot], max_y_[slot], max_z_[slot]));
+            }
+        }
+        node.min_x_[i] = lower.x;
+        node.min_y_[i] = lower.y;
+        node.min_z_[i] = lower.z;
+        node.max_x_[i] = upper.x;
+        node.max_y_[i] = upper.y;
+        node.max_z_[i] = upper.z;
+    }
+}
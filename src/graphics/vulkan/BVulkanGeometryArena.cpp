@@ -0,0 +1,101 @@
+/**
+ * @file BVulkanGeometryArena.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-12
+ */
+
+#include "BVulkanGeometryArena.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "BVulkanDevice.h"
+#include "BVulkanUploader.h"
+
+BVulkanGeometryArena::BVulkanGeometryArena(BVulkanDevice* device, vk::DeviceSize page_size) : device_(device), page_size_(page_size) {
+    auto index_usage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer;
+    index16_pool_.stride_ = sizeof(uint16_t);
+    index16_pool_.usage_ = index_usage;
+    index32_pool_.stride_ = sizeof(uint32_t);
+    index32_pool_.usage_ = index_usage;
+}
+
+BVulkanGeometryArena::Range BVulkanGeometryArena::AllocateVertices(const void* data, uint32_t stride, uint32_t count) {
+    return Allocate(GetVertexPool(stride), data, count);
+}
+
+BVulkanGeometryArena::Range BVulkanGeometryArena::AllocateIndices(const void* data, vk::IndexType index_type, uint32_t count) {
+    return Allocate(GetIndexPool(index_type), data, count);
+}
+
+void BVulkanGeometryArena::FreeVertices(uint32_t stride, Range& range) {
+    Free(GetVertexPool(stride), range);
+}
+
+void BVulkanGeometryArena::FreeIndices(vk::IndexType index_type, Range& range) {
+    Free(GetIndexPool(index_type), range);
+}
+
+const vk::Buffer& BVulkanGeometryArena::VertexBuffer(uint32_t stride, uint32_t page) const {
+    return vertex_pools_.at(stride).pages_.at(page).buffer_.Buffer();
+}
+
+const vk::Buffer& BVulkanGeometryArena::IndexBuffer(vk::IndexType index_type, uint32_t page) const {
+    return GetIndexPool(index_type).pages_.at(page).buffer_.Buffer();
+}
+
+BVulkanGeometryArena::Range BVulkanGeometryArena::Allocate(Pool& pool, const void* data, uint32_t count) {
+    Range range{};
+    if (count == 0) {
+        return range;
+    }
+    vk::DeviceSize offset{0};
+    auto page = std::find_if(pool.pages_.begin(), pool.pages_.end(), [count, &offset](Page& page) {
+        return page.ranges_.Allocate(count, 1, offset);
+    });
+    if (page == pool.pages_.end()) {
+        auto capacity = (std::max)(page_size_ / pool.stride_, vk::DeviceSize{count});
+        Page new_page{};
+        new_page.buffer_ = BVulkanBuffer(device_, capacity * pool.stride_, pool.usage_, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        new_page.ranges_ = BVulkanRangeAllocator(capacity);
+        if (!new_page.ranges_.Allocate(count, 1, offset)) {
+            throw std::runtime_error("Failed to allocate geometry arena range.");
+        }
+        pool.pages_.push_back(std::move(new_page));
+        page = std::prev(pool.pages_.end());
+    }
+    range.page_ = static_cast<uint32_t>(page - pool.pages_.begin());
+    range.offset_ = static_cast<uint32_t>(offset);
+    range.count_ = count;
+    device_->GetUploader().UploadBuffer(data, vk::DeviceSize{count} * pool.stride_, page->buffer_.Buffer(), offset * pool.stride_);
+    return range;
+}
+
+void BVulkanGeometryArena::Free(Pool& pool, Range& range) {
+    if (!range) {
+        return;
+    }
+    device_->GetDeletionQueue().Push([&pool, range]() {
+        pool.pages_.at(range.page_).ranges_.Free(range.offset_, range.count_);
+    });
+    range = {};
+}
+
+BVulkanGeometryArena::Pool& BVulkanGeometryArena::GetVertexPool(uint32_t stride) {
+    auto [it, inserted] = vertex_pools_.try_emplace(stride);
+    if (inserted) {
+        it->second.stride_ = stride;
+        it->second.usage_ = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer;
+    }
+    return it->second;
+}
+
+BVulkanGeometryArena::Pool& BVulkanGeometryArena::GetIndexPool(vk::IndexType index_type) {
+    return index_type == vk::IndexType::eUint16 ? index16_pool_ : index32_pool_;
+}
+
+const BVulkanGeometryArena::Pool& BVulkanGeometryArena::GetIndexPool(vk::IndexType index_type) const {
+    return index_type == vk::IndexType::eUint16 ? index16_pool_ : index32_pool_;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file BVulkanImage.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-08
+ */
+
+#include "BVulkanImage.h"
+
+#include <utility>
+
+#include "BVulkanDevice.h"
+
+BVulkanImage::BVulkanImage(BVulkanDevice* device, uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::ImageAspectFlags aspect, uint32_t mip_levels) : device_(device), format_(format), usage_(usage), extent_(width, height), mip_levels_(mip_levels) {
+    device_->CreateImage(width, height, format, tiling, usage, properties, image_, allocation_, mip_levels_);
+    view_ = device_->CreateImageView(image_, format, aspect, 0, mip_levels_);
+}
+
+BVulkanImage::~BVulkanImage() {
+    Release();
+}
+
+BVulkanImage::BVulkanImage(BVulkanImage&& image) noexcept
+    : device_(std::exchange(image.device_, nullptr)),
+      image_(std::exchange(image.image_, nullptr)),
+      view_(std::exchange(image.view_, nullptr)),
+      allocation_(std::exchange(image.allocation_, {})),
+      format_(std::exchange(image.format_, vk::Format::eUndefined)),
+      usage_(std::exchange(image.usage_, {})),
+      extent_(std::exchange(image.extent_, {})),
+      mip_levels_(std::exchange(image.mip_levels_, 1)) {
+}
+
+BVulkanImage& BVulkanImage::operator=(BVulkanImage&& image) noexcept {
+    if (this != &image) {
+        Release();
+        device_ = std::exchange(image.device_, nullptr);
+        image_ = std::exchange(image.image_, nullptr);
+        view_ = std::exchange(image.view_, nullptr);
+        allocation_ = std::exchange(image.allocation_, {});
+        format_ = std::exchange(image.format_, vk::Format::eUndefined);
+        usage_ = std::exchange(image.usage_, {});
+        extent_ = std::exchange(image.extent_, {});
+        mip_levels_ = std::exchange(image.mip_levels_, 1);
+    }
+    return *this;
+}
+
+const vk::Image& BVulkanImage::Image() const {
+    return image_;
+}
+
+const vk::ImageView& BVulkanImage::View() const {
+    return view_;
+}
+
+vk::Format BVulkanImage::Format() const {
+    return format_;
+}
+
+vk::ImageUsageFlags BVulkanImage::Usage() const {
+    return usage_;
+}
+
+vk::ImageAspectFlags BVulkanImage::Aspect() const {
+    switch (format_) {
+        case vk::Format::eD16UnormS8Uint:
+        case vk::Format::eD24UnormS8Uint:
+        case vk::Format::eD32SfloatS8Uint:
+            return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+        case vk::Format::eD16Unorm:
+        case vk::Format::eX8D24UnormPack32:
+        case vk::Format::eD32Sfloat:
+            return vk::ImageAspectFlagBits::eDepth;
+        case vk::Format::eS8Uint:
+            return vk::ImageAspectFlagBits::eStencil;
+        default:
+            return vk::ImageAspectFlagBits::eColor;
+    }
+}
+
+vk::Extent2D BVulkanImage::Extent() const {
+    return extent_;
+}
+
+uint32_t BVulkanImage::MipLevels() const {
+    return mip_levels_;
+}
+
+void BVulkanImage::Release() {
+    if (!image_) {
+        return;
+    }
+    device_->GetDeletionQueue().Push([device = device_, image = image_, view = view_, allocation = allocation_]() mutable {
+        device->Device().destroyImageView(view);
+        device->DestroyImage(image, allocation);
+    });
+    image_ = nullptr;
+    view_ = nullptr;
+    allocation_ = {};
+}
@@ -0,0 +1,304 @@
+/**
+ * @file BVulkanMeshOptimizer.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-11
+ */
+
+#include "BVulkanMeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+constexpr uint32_t INVALID_INDEX{(std::numeric_limits<uint32_t>::max)()};
+constexpr float CACHE_DECAY_POWER{1.5F};
+constexpr float LAST_TRIANGLE_SCORE{0.75F};
+constexpr float VALENCE_BOOST_SCALE{2.0F};
+constexpr float VALENCE_BOOST_POWER{0.5F};
+
+class CacheSimulator {
+public:
+    CacheSimulator(size_t vertex_count, uint32_t cache_size) : timestamps_(vertex_count, 0), cache_size_(cache_size), timestamp_(cache_size + 1) {
+    }
+
+    bool Touch(uint32_t index) {
+        if (timestamp_ - timestamps_[index] > cache_size_) {
+            timestamps_[index] = timestamp_++;
+            return true;
+        }
+        return false;
+    }
+
+    void Reset() {
+        timestamp_ += cache_size_ + 1;
+    }
+
+private:
+    std::vector<uint32_t> timestamps_{};
+    uint32_t cache_size_{0};
+    uint32_t timestamp_{0};
+};
+
+float VertexScore(int32_t cache_position, uint32_t remaining) {
+    if (remaining == 0) {
+        return -1.0F;
+    }
+    auto score = 0.0F;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            auto scale = 1.0F / static_cast<float>(BVulkanMeshOptimizer::CACHE_SIZE - 3);
+            score = std::pow(1.0F - static_cast<float>(cache_position - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+}
+
+}  // namespace
+
+BVulkanMeshOptimizer::Statistics BVulkanMeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size) {
+    Statistics statistics{};
+    if (indices.empty() || vertex_count == 0) {
+        return statistics;
+    }
+    CacheSimulator cache(vertex_count, cache_size);
+    std::vector<bool> referenced(vertex_count, false);
+    size_t misses = 0;
+    size_t unique = 0;
+    for (auto index : indices) {
+        if (cache.Touch(index)) {
+            ++misses;
+        }
+        if (!referenced[index]) {
+            referenced[index] = true;
+            ++unique;
+        }
+    }
+    statistics.acmr_ = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    statistics.atvr_ = static_cast<float>(misses) / static_cast<float>(unique);
+    return statistics;
+}
+
+std::vector<uint32_t> BVulkanMeshOptimizer::OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertex_count) {
+    auto triangle_count = indices.size() / 3;
+    std::vector<uint32_t> result{};
+    result.reserve(triangle_count * 3);
+    if (triangle_count == 0) {
+        return result;
+    }
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        ++remaining[indices[i]];
+    }
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t i = 0; i < vertex_count; ++i) {
+        offsets[i + 1] = offsets[i] + remaining[i];
+    }
+    std::vector<uint32_t> adjacency(triangle_count * 3);
+    std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        adjacency[filled[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i) {
+        vertex_scores[i] = VertexScore(-1, remaining[i]);
+    }
+    std::vector<float> triangle_scores(triangle_count);
+    for (size_t i = 0; i < triangle_count; ++i) {
+        triangle_scores[i] = vertex_scores[indices[i * 3]] + vertex_scores[indices[i * 3 + 1]] + vertex_scores[indices[i * 3 + 2]];
+    }
+    std::vector<bool> emitted(triangle_count, false);
+
+    std::vector<uint32_t> cache{};
+    std::vector<uint32_t> next_cache{};
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+    auto best = static_cast<uint32_t>(std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+    size_t cursor = 0;
+
+    while (result.size() < triangle_count * 3) {
+        if (best == INVALID_INDEX) {
+            while (emitted[cursor]) {
+                ++cursor;
+            }
+            best = static_cast<uint32_t>(cursor);
+        }
+        emitted[best] = true;
+        std::array<uint32_t, 3> corners{indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+        next_cache.clear();
+        for (auto vertex : corners) {
+            result.push_back(vertex);
+            auto begin = offsets[vertex];
+            auto end = begin + remaining[vertex];
+            auto it = std::find(adjacency.begin() + begin, adjacency.begin() + end, best);
+            std::iter_swap(it, adjacency.begin() + end - 1);
+            --remaining[vertex];
+            if (std::find(next_cache.begin(), next_cache.end(), vertex) == next_cache.end()) {
+                next_cache.push_back(vertex);
+            }
+        }
+        for (auto vertex : cache) {
+            if (std::find(corners.begin(), corners.end(), vertex) == corners.end()) {
+                next_cache.push_back(vertex);
+            }
+        }
+
+        for (size_t i = 0; i < next_cache.size(); ++i) {
+            auto vertex = next_cache[i];
+            auto position = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            vertex_scores[vertex] = VertexScore(position, remaining[vertex]);
+        }
+        best = INVALID_INDEX;
+        auto best_score = -(std::numeric_limits<float>::max)();
+        for (auto vertex : next_cache) {
+            auto begin = offsets[vertex];
+            auto end = begin + remaining[vertex];
+            for (auto i = begin; i < end; ++i) {
+                auto triangle = adjacency[i];
+                auto score = vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+                triangle_scores[triangle] = score;
+                if (score > best_score) {
+                    best_score = score;
+                    best = triangle;
+                }
+            }
+        }
+        if (next_cache.size() > CACHE_SIZE) {
+            next_cache.resize(CACHE_SIZE);
+        }
+        std::swap(cache, next_cache);
+    }
+    return result;
+}
+
+std::vector<uint32_t> BVulkanMeshOptimizer::OptimizeOverdraw(const std::vector<uint32_t>& indices, const float* positions, size_t stride, size_t vertex_count, float threshold) {
+    auto triangle_count = indices.size() / 3;
+    if (triangle_count == 0 || positions == nullptr) {
+        return indices;
+    }
+    auto position = [positions, stride](uint32_t index) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + stride * index);
+    };
+
+    std::vector<size_t> hard_boundaries{0};
+    CacheSimulator cache(vertex_count, CACHE_SIZE);
+    for (size_t i = 0; i < triangle_count; ++i) {
+        auto misses = static_cast<int>(cache.Touch(indices[i * 3])) + static_cast<int>(cache.Touch(indices[i * 3 + 1])) + static_cast<int>(cache.Touch(indices[i * 3 + 2]));
+        if (i > 0 && misses == 3) {
+            hard_boundaries.push_back(i);
+        }
+    }
+    hard_boundaries.push_back(triangle_count);
+
+    std::vector<size_t> clusters{};
+    for (size_t c = 0; c + 1 < hard_boundaries.size(); ++c) {
+        auto start = hard_boundaries[c];
+        auto end = hard_boundaries[c + 1];
+        cache.Reset();
+        size_t cluster_misses = 0;
+        for (auto i = start; i < end; ++i) {
+            cluster_misses += static_cast<size_t>(cache.Touch(indices[i * 3])) + static_cast<size_t>(cache.Touch(indices[i * 3 + 1])) + static_cast<size_t>(cache.Touch(indices[i * 3 + 2]));
+        }
+        auto cluster_threshold = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - start);
+        clusters.push_back(start);
+        cache.Reset();
+        size_t running_misses = 0;
+        auto running_start = start;
+        for (auto i = start; i < end; ++i) {
+            running_misses += static_cast<size_t>(cache.Touch(indices[i * 3])) + static_cast<size_t>(cache.Touch(indices[i * 3 + 1])) + static_cast<size_t>(cache.Touch(indices[i * 3 + 2]));
+            if (i + 1 < end && static_cast<float>(running_misses) / static_cast<float>(i + 1 - running_start) <= cluster_threshold) {
+                clusters.push_back(i + 1);
+                cache.Reset();
+                running_misses = 0;
+                running_start = i + 1;
+            }
+        }
+    }
+    clusters.push_back(triangle_count);
+
+    std::array<double, 3> mesh_centroid{0.0, 0.0, 0.0};
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        const auto* p = position(indices[i]);
+        for (int axis = 0; axis < 3; ++axis) {
+            mesh_centroid[axis] += p[axis];
+        }
+    }
+    for (auto& value : mesh_centroid) {
+        value /= static_cast<double>(triangle_count * 3);
+    }
+
+    auto cluster_count = clusters.size() - 1;
+    std::vector<float> sort_keys(cluster_count);
+    for (size_t c = 0; c < cluster_count; ++c) {
+        std::array<double, 3> centroid{0.0, 0.0, 0.0};
+        std::array<double, 3> normal{0.0, 0.0, 0.0};
+        double area_sum = 0.0;
+        for (auto i = clusters[c]; i < clusters[c + 1]; ++i) {
+            const auto* a = position(indices[i * 3]);
+            const auto* b = position(indices[i * 3 + 1]);
+            const auto* d = position(indices[i * 3 + 2]);
+            std::array<double, 3> ab{b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            std::array<double, 3> ad{d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+            std::array<double, 3> cross{ab[1] * ad[2] - ab[2] * ad[1], ab[2] * ad[0] - ab[0] * ad[2], ab[0] * ad[1] - ab[1] * ad[0]};
+            auto area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+            for (int axis = 0; axis < 3; ++axis) {
+                centroid[axis] += (a[axis] + b[axis] + d[axis]) / 3.0 * area;
+                normal[axis] += cross[axis];
+            }
+            area_sum += area;
+        }
+        auto normal_length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area_sum <= 0.0 || normal_length <= 0.0) {
+            sort_keys[c] = 0.0F;
+            continue;
+        }
+        double key = 0.0;
+        for (int axis = 0; axis < 3; ++axis) {
+            key += (centroid[axis] / area_sum - mesh_centroid[axis]) * normal[axis] / normal_length;
+        }
+        sort_keys[c] = static_cast<float>(key);
+    }
+
+    std::vector<size_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sort_keys](size_t lhs, size_t rhs) {
+        return sort_keys[lhs] > sort_keys[rhs];
+    });
+
+    std::vector<uint32_t> result{};
+    result.reserve(triangle_count * 3);
+    for (auto c : order) {
+        result.insert(result.end(), indices.begin() + static_cast<std::ptrdiff_t>(clusters[c] * 3), indices.begin() + static_cast<std::ptrdiff_t>(clusters[c + 1] * 3));
+    }
+    return result;
+}
+
+std::vector<uint32_t> BVulkanMeshOptimizer::OptimizeVertexFetch(const std::vector<uint32_t>& indices, size_t vertex_count) {
+    std::vector<uint32_t> remap(vertex_count, INVALID_INDEX);
+    uint32_t next = 0;
+    for (auto index : indices) {
+        if (remap[index] == INVALID_INDEX) {
+            remap[index] = next++;
+        }
+    }
+    for (auto& index : remap) {
+        if (index == INVALID_INDEX) {
+            index = next++;
+        }
+    }
+    return remap;
+}
+
+std::vector<uint32_t> BVulkanMeshOptimizer::RemapIndices(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap) {
+    std::vector<uint32_t> result(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        result[i] = remap[indices[i]];
+    }
+    return result;
+}
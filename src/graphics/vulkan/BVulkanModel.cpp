@@ -6,10 +6,19 @@
 
 #include "BVulkanModel.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <utility>
 
 #include "BVulkanDevice.h"
+#include "BVulkanQuantizer.h"
+
+bool BVulkanModel::Vertex::operator==(const Vertex& other) const {
+    return position_ == other.position_ && color_ == other.color_ && normal_ == other.normal_;
+}
 
 std::vector<vk::VertexInputBindingDescription> BVulkanModel::Vertex::GetBindingDescriptions() {
     std::vector<vk::VertexInputBindingDescription> binding_descriptions(1);
@@ -24,49 +33,286 @@ std::vector<vk::VertexInputAttributeDescription> BVulkanModel::Vertex::GetAttrib
     std::vector<vk::VertexInputAttributeDescription> attribute_descriptions{};
     attribute_descriptions.push_back({0, 0, vk::Format::eR32G32B32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Vertex, position_))});
     attribute_descriptions.push_back({1, 0, vk::Format::eR32G32B32A32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Vertex, color_))});
+    attribute_descriptions.push_back({2, 0, vk::Format::eR32G32B32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Vertex, normal_))});
+    return attribute_descriptions;
+}
+
+std::vector<vk::VertexInputBindingDescription> BVulkanModel::PackedVertex::GetBindingDescriptions() {
+    std::vector<vk::VertexInputBindingDescription> binding_descriptions(1);
+    binding_descriptions.at(0)
+        .setBinding(0)
+        .setStride(sizeof(PackedVertex))
+        .setInputRate(vk::VertexInputRate::eVertex);
+    return binding_descriptions;
+}
+
+std::vector<vk::VertexInputAttributeDescription> BVulkanModel::PackedVertex::GetAttributeDescriptions(VertexFormat format) {
+    auto position_format = format == VertexFormat::ePackedHalf ? vk::Format::eR16G16B16A16Sfloat : vk::Format::eR16G16B16A16Snorm;
+    std::vector<vk::VertexInputAttributeDescription> attribute_descriptions{};
+    attribute_descriptions.push_back({0, 0, position_format, static_cast<uint32_t>(offsetof(BVulkanModel::PackedVertex, position_))});
+    attribute_descriptions.push_back({1, 0, vk::Format::eR8G8B8A8Unorm, static_cast<uint32_t>(offsetof(BVulkanModel::PackedVertex, color_))});
+    attribute_descriptions.push_back({2, 0, vk::Format::eR16G16Snorm, static_cast<uint32_t>(offsetof(BVulkanModel::PackedVertex, normal_))});
     return attribute_descriptions;
 }
 
+std::vector<vk::VertexInputBindingDescription> BVulkanModel::Instance::GetBindingDescriptions() {
+    std::vector<vk::VertexInputBindingDescription> binding_descriptions(1);
+    binding_descriptions.at(0)
+        .setBinding(INSTANCE_BINDING)
+        .setStride(sizeof(Instance))
+        .setInputRate(vk::VertexInputRate::eInstance);
+    return binding_descriptions;
+}
+
+std::vector<vk::VertexInputAttributeDescription> BVulkanModel::Instance::GetAttributeDescriptions() {
+    std::vector<vk::VertexInputAttributeDescription> attribute_descriptions{};
+    for (uint32_t column = 0; column < 4; ++column) {
+        attribute_descriptions.push_back({INSTANCE_LOCATION + column, INSTANCE_BINDING, vk::Format::eR32G32B32A32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Instance, transform_) + sizeof(glm::vec4) * column)});
+    }
+    attribute_descriptions.push_back({INSTANCE_LOCATION + 4, INSTANCE_BINDING, vk::Format::eR32G32B32A32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Instance, color_))});
+    attribute_descriptions.push_back({INSTANCE_LOCATION + 5, INSTANCE_BINDING, vk::Format::eR32G32B32A32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Instance, dequantization_scale_))});
+    attribute_descriptions.push_back({INSTANCE_LOCATION + 6, INSTANCE_BINDING, vk::Format::eR32G32B32A32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Instance, dequantization_offset_))});
+    for (uint32_t column = 0; column < 3; ++column) {
+        attribute_descriptions.push_back({INSTANCE_LOCATION + 7 + column, INSTANCE_BINDING, vk::Format::eR32G32B32Sfloat, static_cast<uint32_t>(offsetof(BVulkanModel::Instance, normal_matrix_) + sizeof(glm::vec4) * column)});
+    }
+    return attribute_descriptions;
+}
+
+void BVulkanModel::Builder::LoadTriangles(const std::vector<Vertex>& triangles) {
+    vertices_.clear();
+    indices_.clear();
+    indices_.reserve(triangles.size());
+    std::unordered_map<Vertex, uint32_t> unique_vertices{};
+    unique_vertices.reserve(triangles.size());
+    for (const auto& vertex : triangles) {
+        auto [it, inserted] = unique_vertices.try_emplace(vertex, static_cast<uint32_t>(vertices_.size()));
+        if (inserted) {
+            vertices_.push_back(vertex);
+        }
+        indices_.push_back(it->second);
+    }
+    if (optimize_) {
+        report_ = Optimize();
+    }
+}
+
+BVulkanMeshOptimizer::Report BVulkanModel::Builder::Optimize() {
+    BVulkanMeshOptimizer::Report report{};
+    if (vertices_.empty() || indices_.empty()) {
+        return report;
+    }
+    report.before_ = BVulkanMeshOptimizer::AnalyzeVertexCache(indices_, vertices_.size());
+    indices_ = BVulkanMeshOptimizer::OptimizeVertexCache(indices_, vertices_.size());
+    indices_ = BVulkanMeshOptimizer::OptimizeOverdraw(indices_, &vertices_[0].position_.x, sizeof(Vertex), vertices_.size());
+    auto remap = BVulkanMeshOptimizer::OptimizeVertexFetch(indices_, vertices_.size());
+    indices_ = BVulkanMeshOptimizer::RemapIndices(indices_, remap);
+    vertices_ = BVulkanMeshOptimizer::RemapVertices(vertices_, remap);
+    report.after_ = BVulkanMeshOptimizer::AnalyzeVertexCache(indices_, vertices_.size());
+    return report;
+}
+
 BVulkanModel::BVulkanModel(BVulkanDevice* device, const std::vector<BVulkanModel::Vertex>& vertices) : device_(device) {
+    ComputeBounds(vertices);
     CreateVertexBuffer(vertices);
 }
 
+BVulkanModel::BVulkanModel(BVulkanDevice* device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, VertexFormat format) : device_(device), vertex_format_(format) {
+    ComputeBounds(vertices);
+    if (vertex_format_ == VertexFormat::eFloat) {
+        CreateVertexBuffer(vertices);
+    } else {
+        CreatePackedVertexBuffer(vertices);
+    }
+    CreateIndexBuffer(indices);
+}
+
+BVulkanModel::BVulkanModel(BVulkanDevice* device, const Builder& builder) : BVulkanModel(device, builder.vertices_, builder.indices_, builder.format_) {
+}
+
 BVulkanModel::~BVulkanModel() {
-    device_->Device().waitIdle();
-    device_->Device().destroyBuffer(vertex_buffer_);
-    device_->Device().freeMemory(vertex_buffer_memory_);
+    Release();
+}
+
+BVulkanModel::BVulkanModel(BVulkanModel&& model) noexcept
+    : device_(std::exchange(model.device_, nullptr)),
+      vertex_format_(model.vertex_format_),
+      dequantization_(model.dequantization_),
+      bounding_sphere_(model.bounding_sphere_),
+      bounding_box_(model.bounding_box_),
+      vertex_stride_(std::exchange(model.vertex_stride_, 0)),
+      vertex_range_(std::exchange(model.vertex_range_, {})),
+      index_range_(std::exchange(model.index_range_, {})),
+      index_type_(model.index_type_) {
+}
+
+BVulkanModel& BVulkanModel::operator=(BVulkanModel&& model) noexcept {
+    if (this != &model) {
+        Release();
+        device_ = std::exchange(model.device_, nullptr);
+        vertex_format_ = model.vertex_format_;
+        dequantization_ = model.dequantization_;
+        bounding_sphere_ = model.bounding_sphere_;
+        bounding_box_ = model.bounding_box_;
+        vertex_stride_ = std::exchange(model.vertex_stride_, 0);
+        vertex_range_ = std::exchange(model.vertex_range_, {});
+        index_range_ = std::exchange(model.index_range_, {});
+        index_type_ = model.index_type_;
+    }
+    return *this;
+}
+
+std::vector<vk::VertexInputBindingDescription> BVulkanModel::GetBindingDescriptions(VertexFormat format) {
+    auto binding_descriptions = format == VertexFormat::eFloat ? Vertex::GetBindingDescriptions() : PackedVertex::GetBindingDescriptions();
+    auto instance_descriptions = Instance::GetBindingDescriptions();
+    binding_descriptions.insert(binding_descriptions.end(), instance_descriptions.begin(), instance_descriptions.end());
+    return binding_descriptions;
+}
+
+std::vector<vk::VertexInputAttributeDescription> BVulkanModel::GetAttributeDescriptions(VertexFormat format) {
+    auto attribute_descriptions = format == VertexFormat::eFloat ? Vertex::GetAttributeDescriptions() : PackedVertex::GetAttributeDescriptions(format);
+    auto instance_descriptions = Instance::GetAttributeDescriptions();
+    attribute_descriptions.insert(attribute_descriptions.end(), instance_descriptions.begin(), instance_descriptions.end());
+    return attribute_descriptions;
+}
+
+BVulkanModel::VertexFormat BVulkanModel::GetVertexFormat() const {
+    return vertex_format_;
+}
+
+const glm::mat4& BVulkanModel::GetDequantization() const {
+    return dequantization_;
+}
+
+const glm::vec4& BVulkanModel::GetBoundingSphere() const {
+    return bounding_sphere_;
+}
+
+const BVulkanModel::BoundingBox& BVulkanModel::GetBoundingBox() const {
+    return bounding_box_;
+}
+
+const vk::Buffer& BVulkanModel::GetVertexBuffer() const {
+    return device_->GetGeometryArena().VertexBuffer(vertex_stride_, vertex_range_.page_);
+}
+
+const vk::Buffer& BVulkanModel::GetIndexBuffer() const {
+    return device_->GetGeometryArena().IndexBuffer(index_type_, index_range_.page_);
+}
+
+vk::IndexType BVulkanModel::GetIndexType() const {
+    return index_type_;
+}
+
+bool BVulkanModel::IsIndexed() const {
+    return static_cast<bool>(index_range_);
+}
+
+bool BVulkanModel::IsEmpty() const {
+    return !vertex_range_;
+}
+
+vk::DrawIndexedIndirectCommand BVulkanModel::GetDrawCommand(uint32_t instance_count, uint32_t first_instance) const {
+    vk::DrawIndexedIndirectCommand command{};
+    command
+        .setIndexCount(index_range_.count_)
+        .setInstanceCount(instance_count)
+        .setFirstIndex(index_range_.offset_)
+        .setVertexOffset(static_cast<int32_t>(vertex_range_.offset_))
+        .setFirstInstance(first_instance);
+    return command;
 }
 
 void BVulkanModel::Bind(vk::CommandBuffer& command_buffer) const {
-    std::array<vk::Buffer, 1> buffers{vertex_buffer_};
+    if (IsEmpty()) {
+        return;
+    }
+    std::array<vk::Buffer, 1> buffers{GetVertexBuffer()};
     command_buffer.bindVertexBuffers(0, buffers, {0});
+    if (index_range_) {
+        command_buffer.bindIndexBuffer(GetIndexBuffer(), 0, index_type_);
+    }
+}
+
+void BVulkanModel::Draw(vk::CommandBuffer& command_buffer, uint32_t instance_count, uint32_t first_instance) const {
+    if (index_range_) {
+        command_buffer.drawIndexed(index_range_.count_, instance_count, index_range_.offset_, static_cast<int32_t>(vertex_range_.offset_), first_instance);
+    } else if (vertex_range_) {
+        command_buffer.draw(vertex_range_.count_, instance_count, vertex_range_.offset_, first_instance);
+    }
 }
 
-void BVulkanModel::Draw(vk::CommandBuffer& command_buffer) const {
-    command_buffer.draw(vertex_count_, 1, 0, 0);
+void BVulkanModel::Release() {
+    if (device_ == nullptr) {
+        return;
+    }
+    auto& arena = device_->GetGeometryArena();
+    arena.FreeVertices(vertex_stride_, vertex_range_);
+    arena.FreeIndices(index_type_, index_range_);
 }
 
 void BVulkanModel::CreateVertexBuffer(const std::vector<Vertex>& vertices) {
-    vertex_count_ = static_cast<uint32_t>(vertices.size());
-    vk::DeviceSize buffer_size = sizeof(vertices[0]) * vertex_count_;
-    vk::Buffer staging_buffer{};
-    vk::DeviceMemory staging_buffer_memory{};
-    device_->CreateBuffer(
-        buffer_size,
-        vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-        staging_buffer,
-        staging_buffer_memory);
-    auto* data = device_->Device().mapMemory(staging_buffer_memory, 0, buffer_size);
-    memcpy(data, vertices.data(), buffer_size);
-    device_->Device().unmapMemory(staging_buffer_memory);
-    device_->CreateBuffer(
-        buffer_size,
-        vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-        vk::MemoryPropertyFlagBits::eDeviceLocal,
-        vertex_buffer_,
-        vertex_buffer_memory_);
-    device_->CopyBuffer(staging_buffer, vertex_buffer_, buffer_size);
-    device_->Device().destroyBuffer(staging_buffer);
-    device_->Device().freeMemory(staging_buffer_memory);
+    vertex_stride_ = sizeof(Vertex);
+    vertex_range_ = device_->GetGeometryArena().AllocateVertices(vertices.data(), vertex_stride_, static_cast<uint32_t>(vertices.size()));
+}
+
+void BVulkanModel::CreatePackedVertexBuffer(const std::vector<Vertex>& vertices) {
+    vertex_stride_ = sizeof(PackedVertex);
+    if (vertices.empty()) {
+        return;
+    }
+    std::vector<PackedVertex> packed(vertices.size());
+    glm::vec3 min{};
+    glm::vec3 max{};
+    BVulkanQuantizer::ComputeBounds(&vertices[0].position_.x, sizeof(Vertex), vertices.size(), min, max);
+    auto center = (min + max) * 0.5F;
+    auto half_extent = (max - min) * 0.5F;
+    if (vertex_format_ == VertexFormat::ePackedHalf) {
+        BVulkanQuantizer::QuantizeHalf(&vertices[0].position_.x, sizeof(Vertex), vertices.size(), center, packed[0].position_.data(), sizeof(PackedVertex));
+        dequantization_ = glm::translate(glm::mat4(1.0F), center);
+    } else {
+        BVulkanQuantizer::QuantizeSnorm16(&vertices[0].position_.x, sizeof(Vertex), vertices.size(), center, half_extent, reinterpret_cast<int16_t*>(packed[0].position_.data()), sizeof(PackedVertex));
+        dequantization_ = glm::scale(glm::translate(glm::mat4(1.0F), center), half_extent);
+    }
+    BVulkanQuantizer::QuantizeUnorm8(&vertices[0].color_.x, sizeof(Vertex), vertices.size(), packed[0].color_.data(), sizeof(PackedVertex));
+    BVulkanQuantizer::EncodeOctahedral(&vertices[0].normal_.x, sizeof(Vertex), vertices.size(), packed[0].normal_.data(), sizeof(PackedVertex));
+    vertex_range_ = device_->GetGeometryArena().AllocateVertices(packed.data(), vertex_stride_, static_cast<uint32_t>(packed.size()));
+}
+
+void BVulkanModel::CreateIndexBuffer(const std::vector<uint32_t>& indices) {
+    if (indices.empty()) {
+        return;
+    }
+    auto index_count = static_cast<uint32_t>(indices.size());
+    if (vertex_range_.count_ <= (std::numeric_limits<uint16_t>::max)()) {
+        index_type_ = vk::IndexType::eUint16;
+        std::vector<uint16_t> short_indices(indices.begin(), indices.end());
+        index_range_ = device_->GetGeometryArena().AllocateIndices(short_indices.data(), index_type_, index_count);
+    } else {
+        index_type_ = vk::IndexType::eUint32;
+        index_range_ = device_->GetGeometryArena().AllocateIndices(indices.data(), index_type_, index_count);
+    }
+}
+
+void BVulkanModel::ComputeBounds(const std::vector<Vertex>& vertices) {
+    if (vertices.empty()) {
+        return;
+    }
+    glm::vec3 min{};
+    glm::vec3 max{};
+    BVulkanQuantizer::ComputeBounds(&vertices[0].position_.x, sizeof(Vertex), vertices.size(), min, max);
+    auto center = (min + max) * 0.5F;
+    auto radius = 0.0F;
+    for (const auto& vertex : vertices) {
+        radius = (std::max)(radius, glm::length(vertex.position_ - center));
+    }
+    bounding_sphere_ = glm::vec4(center, radius);
+    bounding_box_.min_ = min;
+    bounding_box_.max_ = max;
+}
+
+size_t std::hash<BVulkanModel::Vertex>::operator()(const BVulkanModel::Vertex& vertex) const {
+    auto seed = std::hash<glm::vec3>{}(vertex.position_);
+    seed ^= std::hash<glm::vec4>{}(vertex.color_) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<glm::vec3>{}(vertex.normal_) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
 }
@@ -6,14 +6,37 @@
 
 #include "BVulkanPipeline.h"
 
-#include <fstream>
-#include <stdexcept>
+#include <algorithm>
+#include <chrono>
 
 #include "BVulkanDevice.h"
 #include "BVulkanModel.h"
 
-BVulkanPipeline::BVulkanPipeline(BVulkanDevice* device, const std::string& vert_shader_path, const std::string& frag_shader_path, const PipelineConfigInfo& config) : device_(device) {
-    CreateGraphicsPipeline(vert_shader_path, frag_shader_path, config);
+namespace {
+
+vk::SpecializationInfo* GetSpecializationInfo(const BVulkanPipeline::SpecializationInfo& specialization, vk::SpecializationInfo& info) {
+    if (specialization.map_entries_.empty()) {
+        return nullptr;
+    }
+    info
+        .setMapEntries(specialization.map_entries_)
+        .setDataSize(specialization.data_.size())
+        .setPData(specialization.data_.data());
+    return &info;
+}
+
+}  // namespace
+
+BVulkanPipeline::BVulkanPipeline(BVulkanDevice* device, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const PipelineConfigInfo& config) : device_(device) {
+    CreateGraphicsPipeline(vert_shader_code, frag_shader_code, config);
+}
+
+BVulkanPipeline::BVulkanPipeline(BVulkanDevice* device, vk::GraphicsPipelineLibraryFlagsEXT library_parts, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const PipelineConfigInfo& config) : device_(device) {
+    CreateGraphicsPipeline(vert_shader_code, frag_shader_code, config, library_parts);
+}
+
+BVulkanPipeline::BVulkanPipeline(BVulkanDevice* device, std::span<const BVulkanPipeline* const> libraries, const PipelineConfigInfo& config, bool link_time_optimization) : device_(device) {
+    LinkGraphicsPipeline(libraries, config, link_time_optimization);
 }
 
 BVulkanPipeline::~BVulkanPipeline() {
@@ -24,6 +47,8 @@ BVulkanPipeline::~BVulkanPipeline() {
 
 BVulkanPipeline::PipelineConfigInfo BVulkanPipeline::DefaultPipelineConfigInfo(vk::PrimitiveTopology primitive_topology) {
     PipelineConfigInfo config{};
+    config.binding_descriptions_ = BVulkanModel::GetBindingDescriptions(BVulkanModel::VertexFormat::eFloat);
+    config.attribute_descriptions_ = BVulkanModel::GetAttributeDescriptions(BVulkanModel::VertexFormat::eFloat);
     config.viewport_info_
         .setViewportCount(1)
         .setPViewports(nullptr)
@@ -82,38 +107,78 @@ BVulkanPipeline::PipelineConfigInfo BVulkanPipeline::DefaultPipelineConfigInfo(v
     return config;
 }
 
+void BVulkanPipeline::EnableExtendedDynamicState(PipelineConfigInfo& config) {
+    for (auto dynamic_state : EXTENDED_DYNAMIC_STATES) {
+        if (!IsDynamicState(config, dynamic_state)) {
+            config.dynamic_states_.push_back(dynamic_state);
+        }
+    }
+    config.dynamic_state_info_
+        .setDynamicStateCount(static_cast<uint32_t>(config.dynamic_states_.size()))
+        .setDynamicStates(config.dynamic_states_);
+}
+
+bool BVulkanPipeline::IsDynamicState(const PipelineConfigInfo& config, vk::DynamicState dynamic_state) {
+    return std::find(config.dynamic_states_.begin(), config.dynamic_states_.end(), dynamic_state) != config.dynamic_states_.end();
+}
+
 void BVulkanPipeline::Bind(const vk::CommandBuffer& buffer) {
     buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphics_pipeline_);
 }
 
-void BVulkanPipeline::CreateGraphicsPipeline(const std::string& vert_shader_path, const std::string& frag_shader_path, const PipelineConfigInfo& config) {
-    auto vert_shader_code = ReadFile(vert_shader_path);
-    auto frag_shader_code = ReadFile(frag_shader_path);
-    vert_shader_module_ = CreateShaderModule(vert_shader_code);
-    frag_shader_module_ = CreateShaderModule(frag_shader_code);
+void BVulkanPipeline::CreateGraphicsPipeline(std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const PipelineConfigInfo& config, vk::GraphicsPipelineLibraryFlagsEXT library_parts) {
+    auto monolithic = !library_parts;
+    auto has_vert_stage = monolithic || (library_parts & vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders);
+    auto has_frag_stage = monolithic || (library_parts & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader);
+    vk::SpecializationInfo vert_specialization_info{};
+    vk::SpecializationInfo frag_specialization_info{};
     vk::PipelineShaderStageCreateInfo vert_shader_stage_info;
     vert_shader_stage_info
         .setStage(vk::ShaderStageFlagBits::eVertex)
-        .setModule(vert_shader_module_)
-        .setPName("main");
+        .setPName("main")
+        .setPSpecializationInfo(GetSpecializationInfo(config.vert_specialization_, vert_specialization_info));
     vk::PipelineShaderStageCreateInfo frag_shader_stage_info;
     frag_shader_stage_info
         .setStage(vk::ShaderStageFlagBits::eFragment)
-        .setModule(frag_shader_module_)
-        .setPName("main");
+        .setPName("main")
+        .setPSpecializationInfo(GetSpecializationInfo(config.frag_specialization_, frag_specialization_info));
     vk::PipelineVertexInputStateCreateInfo vertex_input_info;
-    auto binding_descriptions = BVulkanModel::Vertex::GetBindingDescriptions();
-    auto attribute_descriptions = BVulkanModel::Vertex::GetAttributeDescriptions();
     vertex_input_info
-        .setVertexBindingDescriptionCount(static_cast<uint32_t>(binding_descriptions.size()))
-        .setVertexBindingDescriptions(binding_descriptions)
-        .setVertexAttributeDescriptionCount(static_cast<uint32_t>(attribute_descriptions.size()))
-        .setVertexAttributeDescriptions(attribute_descriptions);
+        .setVertexBindingDescriptionCount(static_cast<uint32_t>(config.binding_descriptions_.size()))
+        .setVertexBindingDescriptions(config.binding_descriptions_)
+        .setVertexAttributeDescriptionCount(static_cast<uint32_t>(config.attribute_descriptions_.size()))
+        .setVertexAttributeDescriptions(config.attribute_descriptions_);
+
+    std::vector<vk::PipelineShaderStageCreateInfo> shader_stages{};
+    if (has_vert_stage) {
+        vert_shader_module_ = CreateShaderModule(vert_shader_code);
+        vert_shader_stage_info.setModule(vert_shader_module_);
+        shader_stages.push_back(vert_shader_stage_info);
+    }
+    if (has_frag_stage) {
+        frag_shader_module_ = CreateShaderModule(frag_shader_code);
+        frag_shader_stage_info.setModule(frag_shader_module_);
+        shader_stages.push_back(frag_shader_stage_info);
+    }
+    auto color_blend_info = config.color_blend_info_;
+    color_blend_info.setAttachments(config.color_blend_attachment_);
+    auto dynamic_state_info = config.dynamic_state_info_;
+    dynamic_state_info.setDynamicStates(config.dynamic_states_);
 
-    std::array<vk::PipelineShaderStageCreateInfo, 2> shader_stages{vert_shader_stage_info, frag_shader_stage_info};
+    vk::PipelineRenderingCreateInfo rendering_info{};
+    rendering_info
+        .setColorAttachmentFormats(config.color_attachment_format_)
+        .setDepthAttachmentFormat(config.depth_attachment_format_);
+
+    vk::GraphicsPipelineLibraryCreateInfoEXT library_info{};
+    library_info
+        .setPNext(config.render_pass_ ? nullptr : &rendering_info)
+        .setFlags(library_parts);
 
     vk::GraphicsPipelineCreateInfo pipeline_info;
     pipeline_info
+        .setPNext(monolithic ? library_info.pNext : &library_info)
+        .setFlags(monolithic ? vk::PipelineCreateFlags{} : vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT)
         .setStageCount(static_cast<uint32_t>(shader_stages.size()))
         .setStages(shader_stages)
         .setPVertexInputState(&vertex_input_info)
@@ -121,33 +186,42 @@ void BVulkanPipeline::CreateGraphicsPipeline(const std::string& vert_shader_path
         .setPViewportState(&config.viewport_info_)
         .setPRasterizationState(&config.rasterization_info_)
         .setPMultisampleState(&config.multisample_info_)
-        .setPColorBlendState(&config.color_blend_info_)
+        .setPColorBlendState(&color_blend_info)
         .setPDepthStencilState(&config.depth_stencil_info_)
-        .setPDynamicState(&config.dynamic_state_info_)
+        .setPDynamicState(&dynamic_state_info)
         .setLayout(config.pipeline_layout_)
         .setRenderPass(config.render_pass_)
         .setSubpass(config.subpass_)
         .setBasePipelineIndex(-1)
         .setBasePipelineHandle(nullptr);
-    graphics_pipeline_ = device_->Device().createGraphicsPipeline(nullptr, pipeline_info).value;
+    auto start = std::chrono::steady_clock::now();
+    graphics_pipeline_ = device_->Device().createGraphicsPipeline(device_->GetPipelineCache(), pipeline_info).value;
+    device_->RecordPipelineCreation(std::chrono::steady_clock::now() - start);
 }
 
-std::vector<char> BVulkanPipeline::ReadFile(const std::string& path) {
-    std::ifstream file(path, std::ios::ate | std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file: " + path + ".");
+void BVulkanPipeline::LinkGraphicsPipeline(std::span<const BVulkanPipeline* const> libraries, const PipelineConfigInfo& config, bool link_time_optimization) {
+    std::vector<vk::Pipeline> library_pipelines{};
+    for (const auto* library : libraries) {
+        library_pipelines.push_back(library->graphics_pipeline_);
     }
-    auto file_size = static_cast<std::streamsize>(file.tellg());
-    std::vector<char> buffer(file_size);
-    file.seekg(0);
-    file.read(buffer.data(), file_size);
-    file.close();
-    return buffer;
+    vk::PipelineLibraryCreateInfoKHR library_info{};
+    library_info.setLibraries(library_pipelines);
+    vk::GraphicsPipelineCreateInfo pipeline_info;
+    pipeline_info
+        .setPNext(&library_info)
+        .setFlags(link_time_optimization ? vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT : vk::PipelineCreateFlags{})
+        .setLayout(config.pipeline_layout_)
+        .setBasePipelineIndex(-1)
+        .setBasePipelineHandle(nullptr);
+    auto start = std::chrono::steady_clock::now();
+    graphics_pipeline_ = device_->Device().createGraphicsPipeline(device_->GetPipelineCache(), pipeline_info).value;
+    device_->RecordPipelineCreation(std::chrono::steady_clock::now() - start);
 }
 
-vk::ShaderModule BVulkanPipeline::CreateShaderModule(const std::vector<char>& code) {
+vk::ShaderModule BVulkanPipeline::CreateShaderModule(std::span<const uint32_t> code) {
     vk::ShaderModuleCreateInfo create_info{};
-    create_info.setCodeSize(code.size());
-    create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    create_info
+        .setCodeSize(code.size_bytes())
+        .setPCode(code.data());
     return device_->Device().createShaderModule(create_info);
 }
@@ -0,0 +1,51 @@
+/**
+ * @file BVulkanPipelineHandle.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-22
+ */
+
+#include "BVulkanPipelineHandle.h"
+
+#include <utility>
+
+namespace {
+
+bool IsReady(const BVulkanPipelineHandle::PipelineFuture& future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+}  // namespace
+
+BVulkanPipelineHandle::BVulkanPipelineHandle(PipelineFuture future, PipelineFuture linked, PipelineFuture fallback) : future_(std::move(future)), linked_(std::move(linked)), fallback_(std::move(fallback)) {
+}
+
+bool BVulkanPipelineHandle::IsReady() const {
+    return ::IsReady(future_);
+}
+
+BVulkanPipeline* BVulkanPipelineHandle::Get() const {
+    auto usable = GetUsable();
+    return ::IsReady(usable) ? usable.get().get() : nullptr;
+}
+
+void BVulkanPipelineHandle::Wait() const {
+    if (!linked_.valid()) {
+        if (future_.valid()) {
+            future_.wait();
+        }
+        return;
+    }
+    while (!::IsReady(linked_) && !::IsReady(future_)) {
+        linked_.wait_for(WAIT_INTERVAL);
+    }
+}
+
+BVulkanPipelineHandle::PipelineFuture BVulkanPipelineHandle::GetUsable() const {
+    if (::IsReady(future_)) {
+        return future_;
+    }
+    if (::IsReady(linked_)) {
+        return linked_;
+    }
+    return fallback_;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file BVulkanPipelineLayoutCache.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-18
+ */
+
+#include "BVulkanPipelineLayoutCache.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#include "BVulkanDevice.h"
+#include "BVulkanShaderLibrary.h"
+
+namespace {
+
+template <typename T>
+void Append(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+BVulkanPipelineLayoutCache::BVulkanPipelineLayoutCache(BVulkanDevice* device) : device_(device) {
+}
+
+BVulkanPipelineLayoutCache::~BVulkanPipelineLayoutCache() {
+    for (auto& [key, layout] : layouts_) {
+        device_->Device().destroyPipelineLayout(layout.pipeline_layout_);
+    }
+    for (auto& [key, set_layout] : set_layouts_) {
+        device_->Device().destroyDescriptorSetLayout(set_layout);
+    }
+}
+
+const BVulkanPipelineLayoutCache::Layout& BVulkanPipelineLayoutCache::GetLayout(const std::vector<std::string>& shader_names, const std::vector<std::pair<uint32_t, uint32_t>>& dynamic_bindings) {
+    std::map<std::pair<uint32_t, uint32_t>, vk::DescriptorSetLayoutBinding> bindings{};
+    uint32_t set_count = 0;
+    Layout layout{};
+    for (const auto& name : shader_names) {
+        const auto& reflection = device_->GetShaderLibrary().GetReflection(name);
+        auto stage = reflection.GetStage();
+        for (const auto& descriptor : reflection.GetDescriptorBindings()) {
+            auto [iter, inserted] = bindings.try_emplace({descriptor.set_, descriptor.binding_});
+            auto& binding = iter->second;
+            if (inserted) {
+                binding
+                    .setBinding(descriptor.binding_)
+                    .setDescriptorType(descriptor.type_)
+                    .setDescriptorCount(descriptor.count_)
+                    .setStageFlags(stage);
+            } else if (binding.descriptorType != descriptor.type_) {
+                throw std::runtime_error("Descriptor binding " + std::to_string(descriptor.binding_) + " of set " + std::to_string(descriptor.set_) + " differs between shaders.");
+            } else {
+                binding
+                    .setDescriptorCount((std::max)(binding.descriptorCount, descriptor.count_))
+                    .setStageFlags(binding.stageFlags | stage);
+            }
+            set_count = (std::max)(set_count, descriptor.set_ + 1);
+        }
+        if (reflection.GetPushConstantSize() > 0) {
+            layout.push_constant_stages_ |= stage;
+            layout.push_constant_size_ = (std::max)(layout.push_constant_size_, reflection.GetPushConstantSize());
+        }
+    }
+    for (const auto& slot : dynamic_bindings) {
+        auto iter = bindings.find(slot);
+        if (iter == bindings.end()) {
+            continue;
+        }
+        auto& binding = iter->second;
+        if (binding.descriptorType == vk::DescriptorType::eUniformBuffer) {
+            binding.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
+        } else if (binding.descriptorType == vk::DescriptorType::eStorageBuffer) {
+            binding.setDescriptorType(vk::DescriptorType::eStorageBufferDynamic);
+        } else {
+            throw std::runtime_error("Only buffer descriptors can use dynamic offsets.");
+        }
+    }
+    std::vector<std::vector<vk::DescriptorSetLayoutBinding>> set_bindings(set_count);
+    for (const auto& [slot, binding] : bindings) {
+        set_bindings[slot.first].push_back(binding);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string key{};
+    for (const auto& set : set_bindings) {
+        layout.set_layouts_.push_back(GetSetLayout(set));
+        Append(key, static_cast<VkDescriptorSetLayout>(layout.set_layouts_.back()));
+    }
+    Append(key, static_cast<VkShaderStageFlags>(layout.push_constant_stages_));
+    Append(key, layout.push_constant_size_);
+    auto iter = layouts_.find(key);
+    if (iter != layouts_.end()) {
+        return iter->second;
+    }
+    vk::PushConstantRange push_constant_range{};
+    push_constant_range
+        .setStageFlags(layout.push_constant_stages_)
+        .setOffset(0)
+        .setSize(layout.push_constant_size_);
+    vk::PipelineLayoutCreateInfo pipeline_info{};
+    pipeline_info.setSetLayouts(layout.set_layouts_);
+    if (layout.push_constant_size_ > 0) {
+        pipeline_info.setPushConstantRanges(push_constant_range);
+    }
+    layout.pipeline_layout_ = device_->Device().createPipelineLayout(pipeline_info);
+    return layouts_.emplace(std::move(key), std::move(layout)).first->second;
+}
+
+size_t BVulkanPipelineLayoutCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return layouts_.size();
+}
+
+vk::DescriptorSetLayout BVulkanPipelineLayoutCache::GetSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) {
+    std::string key{};
+    for (const auto& binding : bindings) {
+        Append(key, binding.binding);
+        Append(key, binding.descriptorType);
+        Append(key, binding.descriptorCount);
+        Append(key, static_cast<VkShaderStageFlags>(binding.stageFlags));
+    }
+    auto iter = set_layouts_.find(key);
+    if (iter != set_layouts_.end()) {
+        return iter->second;
+    }
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.setBindings(bindings);
+    auto set_layout = device_->Device().createDescriptorSetLayout(layout_info);
+    set_layouts_.emplace(std::move(key), set_layout);
+    return set_layout;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file BVulkanPipelineLibrary.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-19
+ */
+
+#include "BVulkanPipelineLibrary.h"
+
+#include "BVulkanDevice.h"
+
+namespace {
+
+template <typename T>
+void Append(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendShader(std::string& key, std::span<const uint32_t> code) {
+    Append(key, code.size());
+    uint64_t hash{14695981039346656037ULL};
+    for (auto word : code) {
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    Append(key, hash);
+}
+
+void AppendSpecialization(std::string& key, const BVulkanPipeline::SpecializationInfo& specialization) {
+    Append(key, specialization.map_entries_.size());
+    for (const auto& entry : specialization.map_entries_) {
+        Append(key, entry.constantID);
+        Append(key, entry.offset);
+        Append(key, entry.size);
+    }
+    Append(key, specialization.data_.size());
+    key.append(reinterpret_cast<const char*>(specialization.data_.data()), specialization.data_.size());
+}
+
+template <typename T>
+void AppendState(std::string& key, const BVulkanPipeline::PipelineConfigInfo& config, vk::DynamicState dynamic_state, const T& value) {
+    Append(key, BVulkanPipeline::IsDynamicState(config, dynamic_state) ? T{} : value);
+}
+
+void AppendAttachments(std::string& key, const BVulkanPipeline::PipelineConfigInfo& config) {
+    Append(key, config.subpass_);
+    Append(key, static_cast<bool>(config.render_pass_));
+    Append(key, config.color_attachment_format_);
+    Append(key, config.depth_attachment_format_);
+}
+
+void AppendMultisample(std::string& key, const BVulkanPipeline::PipelineConfigInfo& config) {
+    const auto& multisample = config.multisample_info_;
+    Append(key, multisample.rasterizationSamples);
+    Append(key, multisample.sampleShadingEnable);
+    Append(key, multisample.minSampleShading);
+    Append(key, multisample.alphaToCoverageEnable);
+    Append(key, multisample.alphaToOneEnable);
+}
+
+vk::PrimitiveTopology GetTopologyClass(vk::PrimitiveTopology topology) {
+    switch (topology) {
+        case vk::PrimitiveTopology::ePointList:
+            return vk::PrimitiveTopology::ePointList;
+        case vk::PrimitiveTopology::eLineList:
+        case vk::PrimitiveTopology::eLineStrip:
+        case vk::PrimitiveTopology::eLineListWithAdjacency:
+        case vk::PrimitiveTopology::eLineStripWithAdjacency:
+            return vk::PrimitiveTopology::eLineList;
+        case vk::PrimitiveTopology::ePatchList:
+            return vk::PrimitiveTopology::ePatchList;
+        default:
+            return vk::PrimitiveTopology::eTriangleList;
+    }
+}
+
+}  // namespace
+
+BVulkanPipelineLibrary::BVulkanPipelineLibrary(BVulkanDevice* device) : device_(device) {
+}
+
+BVulkanPipelineLibrary::~BVulkanPipelineLibrary() {
+    parts_.clear();
+}
+
+std::shared_ptr<BVulkanPipeline> BVulkanPipelineLibrary::Link(std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config, bool link_time_optimization) {
+    std::array<std::shared_ptr<BVulkanPipeline>, PARTS.size()> parts{};
+    std::array<const BVulkanPipeline*, PARTS.size()> libraries{};
+    for (size_t i = 0; i < PARTS.size(); ++i) {
+        parts.at(i) = GetPart(PARTS.at(i), vert_shader_code, frag_shader_code, config);
+        libraries.at(i) = parts.at(i).get();
+    }
+    return std::make_shared<BVulkanPipeline>(device_, libraries, config, link_time_optimization);
+}
+
+size_t BVulkanPipelineLibrary::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return parts_.size();
+}
+
+std::string BVulkanPipelineLibrary::MakeKey(vk::GraphicsPipelineLibraryFlagBitsEXT part, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config) {
+    std::string key{};
+    Append(key, part);
+    Append(key, config.dynamic_states_.size());
+    for (const auto& dynamic_state : config.dynamic_states_) {
+        Append(key, dynamic_state);
+    }
+    switch (part) {
+        case vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface: {
+            Append(key, config.binding_descriptions_.size());
+            for (const auto& binding : config.binding_descriptions_) {
+                Append(key, binding.binding);
+                Append(key, binding.stride);
+                Append(key, binding.inputRate);
+            }
+            Append(key, config.attribute_descriptions_.size());
+            for (const auto& attribute : config.attribute_descriptions_) {
+                Append(key, attribute.location);
+                Append(key, attribute.binding);
+                Append(key, attribute.format);
+                Append(key, attribute.offset);
+            }
+            auto topology = config.input_assembly_info_.topology;
+            Append(key, BVulkanPipeline::IsDynamicState(config, vk::DynamicState::ePrimitiveTopology) ? GetTopologyClass(topology) : topology);
+            Append(key, config.input_assembly_info_.primitiveRestartEnable);
+            break;
+        }
+        case vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders: {
+            AppendShader(key, vert_shader_code);
+            AppendSpecialization(key, config.vert_specialization_);
+            Append(key, config.viewport_info_.viewportCount);
+            Append(key, config.viewport_info_.scissorCount);
+            const auto& rasterization = config.rasterization_info_;
+            Append(key, rasterization.depthClampEnable);
+            Append(key, rasterization.rasterizerDiscardEnable);
+            Append(key, rasterization.polygonMode);
+            AppendState(key, config, vk::DynamicState::eCullMode, rasterization.cullMode);
+            AppendState(key, config, vk::DynamicState::eFrontFace, rasterization.frontFace);
+            Append(key, rasterization.depthBiasEnable);
+            Append(key, rasterization.depthBiasConstantFactor);
+            Append(key, rasterization.depthBiasClamp);
+            Append(key, rasterization.depthBiasSlopeFactor);
+            Append(key, rasterization.lineWidth);
+            Append(key, static_cast<VkPipelineLayout>(config.pipeline_layout_));
+            AppendAttachments(key, config);
+            break;
+        }
+        case vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader: {
+            AppendShader(key, frag_shader_code);
+            AppendSpecialization(key, config.frag_specialization_);
+            AppendMultisample(key, config);
+            const auto& depth_stencil = config.depth_stencil_info_;
+            AppendState(key, config, vk::DynamicState::eDepthTestEnable, depth_stencil.depthTestEnable);
+            AppendState(key, config, vk::DynamicState::eDepthWriteEnable, depth_stencil.depthWriteEnable);
+            AppendState(key, config, vk::DynamicState::eDepthCompareOp, depth_stencil.depthCompareOp);
+            AppendState(key, config, vk::DynamicState::eDepthBoundsTestEnable, depth_stencil.depthBoundsTestEnable);
+            Append(key, depth_stencil.stencilTestEnable);
+            Append(key, depth_stencil.front);
+            Append(key, depth_stencil.back);
+            Append(key, depth_stencil.minDepthBounds);
+            Append(key, depth_stencil.maxDepthBounds);
+            Append(key, static_cast<VkPipelineLayout>(config.pipeline_layout_));
+            AppendAttachments(key, config);
+            break;
+        }
+        case vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface: {
+            AppendMultisample(key, config);
+            const auto& attachment = config.color_blend_attachment_;
+            Append(key, attachment.blendEnable);
+            Append(key, attachment.srcColorBlendFactor);
+            Append(key, attachment.dstColorBlendFactor);
+            Append(key, attachment.colorBlendOp);
+            Append(key, attachment.srcAlphaBlendFactor);
+            Append(key, attachment.dstAlphaBlendFactor);
+            Append(key, attachment.alphaBlendOp);
+            Append(key, attachment.colorWriteMask);
+            Append(key, config.color_blend_info_.logicOpEnable);
+            Append(key, config.color_blend_info_.logicOp);
+            Append(key, config.color_blend_info_.blendConstants);
+            AppendAttachments(key, config);
+            break;
+        }
+    }
+    return key;
+}
+
+std::shared_ptr<BVulkanPipeline> BVulkanPipelineLibrary::GetPart(vk::GraphicsPipelineLibraryFlagBitsEXT part, std::span<const uint32_t> vert_shader_code, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config) {
+    auto key = MakeKey(part, vert_shader_code, frag_shader_code, config);
+    std::promise<std::shared_ptr<BVulkanPipeline>> promise{};
+    PartFuture future{};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = parts_.find(key);
+        if (iter != parts_.end()) {
+            future = iter->second;
+        } else {
+            parts_.emplace(std::move(key), promise.get_future().share());
+        }
+    }
+    if (future.valid()) {
+        return future.get();
+    }
+    try {
+        auto pipeline = std::make_shared<BVulkanPipeline>(device_, part, vert_shader_code, frag_shader_code, config);
+        promise.set_value(pipeline);
+        return pipeline;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
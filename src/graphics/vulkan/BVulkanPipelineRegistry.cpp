@@ -0,0 +1,87 @@
+/**
+ * @file BVulkanPipelineRegistry.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-16
+ */
+
+#include "BVulkanPipelineRegistry.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "BVulkanDevice.h"
+#include "BVulkanShaderLibrary.h"
+
+namespace {
+
+void AppendString(std::string& key, const std::string& value) {
+    auto size = value.size();
+    key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    key.append(value);
+}
+
+}  // namespace
+
+BVulkanPipelineRegistry::BVulkanPipelineRegistry(BVulkanDevice* device) : device_(device) {
+    auto thread_count = (std::min)(static_cast<size_t>((std::max)(std::thread::hardware_concurrency(), 2U) - 1), MAX_THREAD_COUNT);
+    thread_pool_ = std::make_unique<BVulkanThreadPool>(thread_count);
+    if (device_->HasGraphicsPipelineLibrary()) {
+        library_ = std::make_unique<BVulkanPipelineLibrary>(device_);
+    }
+}
+
+BVulkanPipelineRegistry::~BVulkanPipelineRegistry() {
+    thread_pool_.reset();
+    pipelines_.clear();
+    library_.reset();
+}
+
+BVulkanPipelineRegistry::Handle BVulkanPipelineRegistry::Acquire(const std::string& vert_shader_name, const std::string& frag_shader_name, const BVulkanPipeline::PipelineConfigInfo& config, const Handle& fallback) {
+    auto vert_shader_code = device_->GetShaderLibrary().GetShader(vert_shader_name);
+    auto frag_shader_code = device_->GetShaderLibrary().GetShader(frag_shader_name);
+    auto key = MakeKey(vert_shader_name, vert_shader_code, frag_shader_name, frag_shader_code, config);
+    auto fallback_future = fallback.GetUsable();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = pipelines_.find(key);
+    if (iter != pipelines_.end()) {
+        return Handle(iter->second.future_, iter->second.linked_, fallback_future);
+    }
+    device_->GetShaderLibrary().GetReflection(vert_shader_name).ValidateVertexInput(config.attribute_descriptions_);
+    PipelineFuture linked{};
+    if (library_) {
+        auto linked_task = std::make_shared<std::packaged_task<std::shared_ptr<BVulkanPipeline>()>>([library = library_.get(), vert_shader_code, frag_shader_code, config]() {
+            return library->Link(vert_shader_code, frag_shader_code, config, false);
+        });
+        linked = linked_task->get_future().share();
+        thread_pool_->Submit([linked_task]() {
+            (*linked_task)();
+        });
+    }
+    auto task = std::make_shared<std::packaged_task<std::shared_ptr<BVulkanPipeline>()>>([device = device_, library = library_.get(), vert_shader_code, frag_shader_code, config]() {
+        if (library != nullptr) {
+            return library->Link(vert_shader_code, frag_shader_code, config, true);
+        }
+        return std::make_shared<BVulkanPipeline>(device, vert_shader_code, frag_shader_code, config);
+    });
+    auto future = task->get_future().share();
+    pipelines_.emplace(std::move(key), Entry{future, linked});
+    thread_pool_->Submit([task]() {
+        (*task)();
+    });
+    return Handle(future, linked, fallback_future);
+}
+
+size_t BVulkanPipelineRegistry::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pipelines_.size();
+}
+
+std::string BVulkanPipelineRegistry::MakeKey(const std::string& vert_shader_name, std::span<const uint32_t> vert_shader_code, const std::string& frag_shader_name, std::span<const uint32_t> frag_shader_code, const BVulkanPipeline::PipelineConfigInfo& config) {
+    std::string key{};
+    AppendString(key, vert_shader_name);
+    AppendString(key, frag_shader_name);
+    for (auto part : BVulkanPipelineLibrary::PARTS) {
+        AppendString(key, BVulkanPipelineLibrary::MakeKey(part, vert_shader_code, frag_shader_code, config));
+    }
+    return key;
+}
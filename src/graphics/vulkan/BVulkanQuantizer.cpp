@@ -0,0 +1,242 @@
+/**
+ * @file BVulkanQuantizer.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-10
+ */
+
+#include "BVulkanQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define B_QUANTIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__F16C__) || defined(__AVX2__)
+#define B_QUANTIZER_F16C
+#include <immintrin.h>
+#endif
+
+namespace {
+
+template <typename T>
+const T* Element(const T* base, size_t stride, size_t index) {
+    return reinterpret_cast<const T*>(reinterpret_cast<const char*>(base) + stride * index);
+}
+
+template <typename T>
+T* Element(T* base, size_t stride, size_t index) {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(base) + stride * index);
+}
+
+int16_t FloatToSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0F, 1.0F) * 32767.0F));
+}
+
+}  // namespace
+
+void BVulkanQuantizer::ComputeBounds(const float* positions, size_t stride, size_t count, glm::vec3& min, glm::vec3& max) {
+    if (count == 0) {
+        min = glm::vec3(0.0F);
+        max = glm::vec3(0.0F);
+        return;
+    }
+#if defined(B_QUANTIZER_SSE2)
+    const auto* first = Element(positions, stride, 0);
+    auto lower = _mm_set_ps(0.0F, first[2], first[1], first[0]);
+    auto upper = lower;
+    for (size_t i = 1; i < count; ++i) {
+        const auto* p = Element(positions, stride, i);
+        auto value = _mm_set_ps(0.0F, p[2], p[1], p[0]);
+        lower = _mm_min_ps(lower, value);
+        upper = _mm_max_ps(upper, value);
+    }
+    alignas(16) float lower_values[4];
+    alignas(16) float upper_values[4];
+    _mm_store_ps(lower_values, lower);
+    _mm_store_ps(upper_values, upper);
+    min = glm::vec3(lower_values[0], lower_values[1], lower_values[2]);
+    max = glm::vec3(upper_values[0], upper_values[1], upper_values[2]);
+#else
+    const auto* first = Element(positions, stride, 0);
+    min = glm::vec3(first[0], first[1], first[2]);
+    max = min;
+    for (size_t i = 1; i < count; ++i) {
+        const auto* p = Element(positions, stride, i);
+        min = glm::min(min, glm::vec3(p[0], p[1], p[2]));
+        max = glm::max(max, glm::vec3(p[0], p[1], p[2]));
+    }
+#endif
+}
+
+void BVulkanQuantizer::QuantizeSnorm16(const float* positions, size_t stride, size_t count, const glm::vec3& center, const glm::vec3& half_extent, int16_t* dst, size_t dst_stride) {
+    glm::vec3 inverse_extent{
+        half_extent[0] > 0.0F ? 1.0F / half_extent[0] : 0.0F,
+        half_extent[1] > 0.0F ? 1.0F / half_extent[1] : 0.0F,
+        half_extent[2] > 0.0F ? 1.0F / half_extent[2] : 0.0F};
+#if defined(B_QUANTIZER_SSE2)
+    auto offset = _mm_set_ps(0.0F, center[2], center[1], center[0]);
+    auto scale = _mm_set_ps(0.0F, inverse_extent[2] * 32767.0F, inverse_extent[1] * 32767.0F, inverse_extent[0] * 32767.0F);
+    auto lower = _mm_set1_ps(-32767.0F);
+    auto upper = _mm_set1_ps(32767.0F);
+    for (size_t i = 0; i < count; ++i) {
+        const auto* p = Element(positions, stride, i);
+        auto value = _mm_mul_ps(_mm_sub_ps(_mm_set_ps(0.0F, p[2], p[1], p[0]), offset), scale);
+        value = _mm_min_ps(_mm_max_ps(value, lower), upper);
+        auto packed = _mm_packs_epi32(_mm_cvtps_epi32(value), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(Element(dst, dst_stride, i)), packed);
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        const auto* p = Element(positions, stride, i);
+        auto* q = Element(dst, dst_stride, i);
+        for (int axis = 0; axis < 3; ++axis) {
+            q[axis] = FloatToSnorm16((p[axis] - center[axis]) * inverse_extent[axis]);
+        }
+        q[3] = 0;
+    }
+#endif
+}
+
+void BVulkanQuantizer::QuantizeHalf(const float* positions, size_t stride, size_t count, const glm::vec3& center, uint16_t* dst, size_t dst_stride) {
+#if defined(B_QUANTIZER_F16C)
+    auto offset = _mm_set_ps(0.0F, center[2], center[1], center[0]);
+    for (size_t i = 0; i < count; ++i) {
+        const auto* p = Element(positions, stride, i);
+        auto value = _mm_sub_ps(_mm_set_ps(0.0F, p[2], p[1], p[0]), offset);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(Element(dst, dst_stride, i)), _mm_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        const auto* p = Element(positions, stride, i);
+        auto* q = Element(dst, dst_stride, i);
+        for (int axis = 0; axis < 3; ++axis) {
+            q[axis] = FloatToHalf(p[axis] - center[axis]);
+        }
+        q[3] = 0;
+    }
+#endif
+}
+
+void BVulkanQuantizer::QuantizeUnorm8(const float* colors, size_t stride, size_t count, uint8_t* dst, size_t dst_stride) {
+#if defined(B_QUANTIZER_SSE2)
+    auto lower = _mm_setzero_ps();
+    auto upper = _mm_set1_ps(255.0F);
+    for (size_t i = 0; i < count; ++i) {
+        auto value = _mm_mul_ps(_mm_loadu_ps(Element(colors, stride, i)), upper);
+        value = _mm_min_ps(_mm_max_ps(value, lower), upper);
+        auto words = _mm_packs_epi32(_mm_cvtps_epi32(value), _mm_setzero_si128());
+        auto bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, _mm_setzero_si128()));
+        memcpy(Element(dst, dst_stride, i), &bytes, sizeof(bytes));
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        const auto* c = Element(colors, stride, i);
+        auto* q = Element(dst, dst_stride, i);
+        for (int channel = 0; channel < 4; ++channel) {
+            q[channel] = static_cast<uint8_t>(std::lround(std::clamp(c[channel], 0.0F, 1.0F) * 255.0F));
+        }
+    }
+#endif
+}
+
+void BVulkanQuantizer::EncodeOctahedral(const float* normals, size_t stride, size_t count, int16_t* dst, size_t dst_stride) {
+    size_t i = 0;
+#if defined(B_QUANTIZER_SSE2)
+    auto sign_mask = _mm_set1_ps(-0.0F);
+    auto zero = _mm_setzero_ps();
+    auto one = _mm_set1_ps(1.0F);
+    auto minus_one = _mm_set1_ps(-1.0F);
+    auto scale = _mm_set1_ps(32767.0F);
+    for (; i + 4 <= count; i += 4) {
+        const auto* n0 = Element(normals, stride, i);
+        const auto* n1 = Element(normals, stride, i + 1);
+        const auto* n2 = Element(normals, stride, i + 2);
+        const auto* n3 = Element(normals, stride, i + 3);
+        auto x = _mm_set_ps(n3[0], n2[0], n1[0], n0[0]);
+        auto y = _mm_set_ps(n3[1], n2[1], n1[1], n0[1]);
+        auto z = _mm_set_ps(n3[2], n2[2], n1[2], n0[2]);
+        auto abs_x = _mm_andnot_ps(sign_mask, x);
+        auto abs_y = _mm_andnot_ps(sign_mask, y);
+        auto sum = _mm_add_ps(_mm_add_ps(abs_x, abs_y), _mm_andnot_ps(sign_mask, z));
+        auto valid = _mm_cmpgt_ps(sum, zero);
+        auto inverse = _mm_and_ps(_mm_div_ps(one, sum), valid);
+        x = _mm_mul_ps(x, inverse);
+        y = _mm_mul_ps(y, inverse);
+        abs_x = _mm_mul_ps(abs_x, inverse);
+        abs_y = _mm_mul_ps(abs_y, inverse);
+        auto positive_x = _mm_cmpge_ps(x, zero);
+        auto positive_y = _mm_cmpge_ps(y, zero);
+        auto folded_x = _mm_mul_ps(_mm_sub_ps(one, abs_y), _mm_or_ps(_mm_and_ps(positive_x, one), _mm_andnot_ps(positive_x, minus_one)));
+        auto folded_y = _mm_mul_ps(_mm_sub_ps(one, abs_x), _mm_or_ps(_mm_and_ps(positive_y, one), _mm_andnot_ps(positive_y, minus_one)));
+        auto fold = _mm_and_ps(_mm_cmplt_ps(z, zero), valid);
+        x = _mm_or_ps(_mm_and_ps(fold, folded_x), _mm_andnot_ps(fold, x));
+        y = _mm_or_ps(_mm_and_ps(fold, folded_y), _mm_andnot_ps(fold, y));
+        x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, minus_one), one), scale);
+        y = _mm_mul_ps(_mm_min_ps(_mm_max_ps(y, minus_one), one), scale);
+        alignas(16) int16_t values[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_packs_epi32(_mm_cvtps_epi32(_mm_unpacklo_ps(x, y)), _mm_cvtps_epi32(_mm_unpackhi_ps(x, y))));
+        for (size_t lane = 0; lane < 4; ++lane) {
+            memcpy(Element(dst, dst_stride, i + lane), values + lane * 2, sizeof(int16_t) * 2);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const auto* n = Element(normals, stride, i);
+        auto* q = Element(dst, dst_stride, i);
+        auto sum = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+        if (sum <= 0.0F) {
+            q[0] = 0;
+            q[1] = 0;
+            continue;
+        }
+        auto x = n[0] / sum;
+        auto y = n[1] / sum;
+        if (n[2] < 0.0F) {
+            auto folded_x = (1.0F - std::abs(y)) * (x >= 0.0F ? 1.0F : -1.0F);
+            auto folded_y = (1.0F - std::abs(x)) * (y >= 0.0F ? 1.0F : -1.0F);
+            x = folded_x;
+            y = folded_y;
+        }
+        q[0] = FloatToSnorm16(x);
+        q[1] = FloatToSnorm16(y);
+    }
+}
+
+uint16_t BVulkanQuantizer::FloatToHalf(float value) {
+    uint32_t bits{};
+    memcpy(&bits, &value, sizeof(bits));
+    auto sign = static_cast<uint32_t>((bits >> 16) & 0x8000);
+    auto biased = static_cast<int32_t>((bits >> 23) & 0xFF);
+    auto mantissa = bits & 0x7FFFFF;
+    if (biased == 0xFF) {
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    auto exponent = biased - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000;
+        auto shift = static_cast<uint32_t>(14 - exponent);
+        auto half = mantissa >> shift;
+        auto remainder = mantissa & ((1U << shift) - 1);
+        auto halfway = 1U << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    auto half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    auto remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        ++half;
+    }
+    return static_cast<uint16_t>(half);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file BVulkanRangeAllocator.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-12
+ */
+
+#include "BVulkanRangeAllocator.h"
+
+#include <algorithm>
+#include <iterator>
+
+BVulkanRangeAllocator::BVulkanRangeAllocator(vk::DeviceSize size) : size_(size) {
+    if (size_ > 0) {
+        free_ranges_.emplace(0, size_);
+    }
+}
+
+bool BVulkanRangeAllocator::Allocate(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset) {
+    if (size == 0 || size_ - used_ < size) {
+        return false;
+    }
+    alignment = (std::max)(alignment, vk::DeviceSize{1});
+    for (auto it = free_ranges_.begin(); it != free_ranges_.end(); ++it) {
+        auto [range_offset, range_size] = *it;
+        auto aligned = (range_offset + alignment - 1) / alignment * alignment;
+        auto padding = aligned - range_offset;
+        if (padding + size > range_size) {
+            continue;
+        }
+        free_ranges_.erase(it);
+        if (padding > 0) {
+            free_ranges_.emplace(range_offset, padding);
+        }
+        auto tail = range_size - padding - size;
+        if (tail > 0) {
+            free_ranges_.emplace(aligned + size, tail);
+        }
+        used_ += size;
+        offset = aligned;
+        return true;
+    }
+    return false;
+}
+
+void BVulkanRangeAllocator::Free(vk::DeviceSize offset, vk::DeviceSize size) {
+    used_ -= size;
+    auto next = free_ranges_.lower_bound(offset);
+    if (next != free_ranges_.end() && offset + size == next->first) {
+        size += next->second;
+        next = free_ranges_.erase(next);
+    }
+    if (next != free_ranges_.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    free_ranges_.emplace(offset, size);
+}
+
+vk::DeviceSize BVulkanRangeAllocator::Size() const {
+    return size_;
+}
+
+vk::DeviceSize BVulkanRangeAllocator::Used() const {
+    return used_;
+}
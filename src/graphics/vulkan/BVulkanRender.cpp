@@ -6,69 +6,152 @@
 
 #include "BVulkanRender.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "BGraphicsCanvas.h"
 #include "BVulkanDevice.h"
+#include "BVulkanFrameContext.h"
 #include "BVulkanSwapchain.h"
+#include "BVulkanUploader.h"
 
-BVulkanRender::BVulkanRender(BVulkanDevice* device, BGraphicsCanvas* canvas) : device_(device), canvas_(canvas) {
-    RecreateSwapchain();
-    CreateCommandBuffers();
+BVulkanRender::BVulkanRender(BVulkanDevice* device, BGraphicsCanvas* canvas, const BVulkanSwapchain::Config& swapchain_config, size_t frames_in_flight) : device_(device), canvas_(canvas), frames_in_flight_((std::max)(frames_in_flight, size_t{1})) {
+    swapchain_ = std::make_unique<BVulkanSwapchain>(device_, canvas_->Width(), canvas_->Height(), frames_in_flight_, swapchain_config);
+    canvas_extent_ = vk::Extent2D{static_cast<uint32_t>(canvas_->Width()), static_cast<uint32_t>(canvas_->Height())};
+    for (size_t i = 0; i < frames_in_flight_; ++i) {
+        frames_.push_back(std::make_unique<BVulkanFrameContext>(device_, i));
+    }
 }
 
 BVulkanRender::~BVulkanRender() {
     device_->Device().waitIdle();
+    frames_.clear();
     swapchain_.reset();
-    FreeCommandBuffers();
+    device_->GetDeletionQueue().Flush();
 }
 
 const vk::RenderPass& BVulkanRender::GetSwapchainRenderPass() const {
     return swapchain_->GetRenderPass();
 }
 
+const vk::Format& BVulkanRender::GetSwapchainColorFormat() const {
+    return swapchain_->GetSwapchainImageFormat();
+}
+
+const vk::Format& BVulkanRender::GetSwapchainDepthFormat() const {
+    return swapchain_->GetDepthFormat();
+}
+
+vk::Extent2D BVulkanRender::GetSwapchainExtent() const {
+    return swapchain_->GetSwapchainExtent();
+}
+
 float BVulkanRender::GetAspectRatio() const {
     return swapchain_->GetExtentAspectRatio();
 }
 
+size_t BVulkanRender::GetFrameCount() const {
+    return frames_in_flight_;
+}
+
+size_t BVulkanRender::GetFrameIndex() const {
+    return swapchain_->GetCurrentFrame();
+}
+
+BVulkanFrameContext& BVulkanRender::GetCurrentFrame() const {
+    return *frames_[swapchain_->GetCurrentFrame()];
+}
+
+const BVulkanImage& BVulkanRender::GetCurrentDepthImage() const {
+    return swapchain_->GetDepthImage(swapchain_->GetCurrentFrame());
+}
+
+const BVulkanSwapchain::Config& BVulkanRender::GetSwapchainConfig() const {
+    return swapchain_->GetConfig();
+}
+
+void BVulkanRender::SetSwapchainConfig(const BVulkanSwapchain::Config& config) {
+    const auto& current = swapchain_->GetConfig();
+    if (config.present_mode_ != current.present_mode_ || config.image_count_ != current.image_count_) {
+        swapchain_dirty_ = true;
+    } else if (config.sampled_depth_ != current.sampled_depth_) {
+        depth_dirty_ = true;
+    }
+    swapchain_->SetConfig(config);
+}
+
+vk::PresentModeKHR BVulkanRender::GetPresentMode() const {
+    return swapchain_->GetPresentMode();
+}
+
+void BVulkanRender::SetFrameRateLimit(double frames_per_second) {
+    frame_interval_ = frames_per_second > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frames_per_second)) : Clock::duration::zero();
+    next_frame_time_ = {};
+}
+
+const BVulkanRender::FrameTiming& BVulkanRender::GetFrameTiming() const {
+    return frame_timing_;
+}
+
 vk::CommandBuffer BVulkanRender::BeginFrame() {
+    if (!RecreateSwapchain()) {
+        return nullptr;
+    }
     try {
+        auto wait_begin = Clock::now();
+        swapchain_->WaitForFrame();
+        auto limiter_begin = Clock::now();
+        LimitFrameRate();
+        auto acquire_begin = Clock::now();
         current_image_index_ = swapchain_->AcquireNextImage();
+        frame_timing_.latch_time_ = Clock::now();
+        frame_timing_.gpu_wait_ = limiter_begin - wait_begin;
+        frame_timing_.limiter_wait_ = acquire_begin - limiter_begin;
+        frame_timing_.acquire_wait_ = frame_timing_.latch_time_ - acquire_begin;
         is_frame_started_ = true;
-        auto command_buffer = GetCurrentCommandBuffer();
-        vk::CommandBufferBeginInfo begin_info{};
-        command_buffer.begin(begin_info);
+        device_->GetDeletionQueue().Collect();
+        auto& frame = GetCurrentFrame();
+        auto command_buffer = frame.Begin();
+        device_->GetUploader().Flush();
+        device_->GetUploader().RecordAcquires(command_buffer, frame.GetUploadSemaphores(), frame.GetUploadWaitValues(), frame.GetUploadWaitStages());
         return command_buffer;
     } catch ([[maybe_unused]] const vk::OutOfDateKHRError& e) {
-        RecreateSwapchain();
+        swapchain_dirty_ = true;
         return nullptr;
     }
 }
 
 void BVulkanRender::EndFrame() {
     try {
-        auto command_buffer = GetCurrentCommandBuffer();
-        command_buffer.end();
-        swapchain_->SubmitCommandBuffers(command_buffer, current_image_index_);
+        auto& frame = GetCurrentFrame();
+        frame.GetCommandBuffer().end();
         is_frame_started_ = false;
+        swapchain_->SubmitCommandBuffers(frame.GetCommandBuffer(), current_image_index_, frame.GetUploadSemaphores(), frame.GetUploadWaitValues(), frame.GetUploadWaitStages());
     } catch ([[maybe_unused]] const vk::OutOfDateKHRError& e) {
-        RecreateSwapchain();
+        swapchain_dirty_ = true;
     }
+    device_->GetUploader().Flush();
 }
 
 void BVulkanRender::BeginSwapchainRenderPass(vk::CommandBuffer command_buffer) {
-    vk::RenderPassBeginInfo render_pass_info{};
-    render_pass_info
-        .setRenderPass(swapchain_->GetRenderPass())
-        .setFramebuffer(swapchain_->GetFrameBuffer(current_image_index_));
-    render_pass_info.renderArea
-        .setOffset({0, 0})
-        .setExtent(swapchain_->GetSwapchainExtent());
-    std::array<vk::ClearValue, 2> clear_values{};
-    clear_values[0].setColor({0.17F, 0.17F, 0.17F, 1.0F});
-    clear_values[1].setDepthStencil({1.0F, 0});
-    render_pass_info
-        .setClearValueCount(static_cast<uint32_t>(clear_values.size()))
-        .setClearValues(clear_values);
-    command_buffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
+    if (swapchain_->GetRenderPass()) {
+        vk::RenderPassBeginInfo render_pass_info{};
+        render_pass_info
+            .setRenderPass(swapchain_->GetRenderPass())
+            .setFramebuffer(swapchain_->GetFrameBuffer(current_image_index_, swapchain_->GetCurrentFrame()));
+        render_pass_info.renderArea
+            .setOffset({0, 0})
+            .setExtent(swapchain_->GetSwapchainExtent());
+        std::array<vk::ClearValue, 2> clear_values{};
+        clear_values[0].setColor(CLEAR_COLOR);
+        clear_values[1].setDepthStencil({1.0F, 0});
+        render_pass_info
+            .setClearValueCount(static_cast<uint32_t>(clear_values.size()))
+            .setClearValues(clear_values);
+        command_buffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
+    } else {
+        BeginDynamicRendering(command_buffer);
+    }
     vk::Viewport viewport{};
     viewport
         .setX(0.0F)
@@ -83,33 +166,106 @@ void BVulkanRender::BeginSwapchainRenderPass(vk::CommandBuffer command_buffer) {
 }
 
 void BVulkanRender::EndSwapchainRenderPass(vk::CommandBuffer command_buffer) {
-    command_buffer.endRenderPass();
+    if (swapchain_->GetRenderPass()) {
+        command_buffer.endRenderPass();
+    } else {
+        EndDynamicRendering(command_buffer);
+    }
 }
 
-void BVulkanRender::RecreateSwapchain() {
-    device_->Device().waitIdle();
-    swapchain_.reset(nullptr);
-    swapchain_ = std::make_unique<BVulkanSwapchain>(device_, canvas_->Width(), canvas_->Height());
+void BVulkanRender::BeginDynamicRendering(vk::CommandBuffer command_buffer) {
+    std::array<vk::ImageMemoryBarrier, 2> barriers{};
+    barriers[0]
+        .setSrcAccessMask(vk::AccessFlagBits::eNone)
+        .setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+        .setOldLayout(vk::ImageLayout::eUndefined)
+        .setNewLayout(vk::ImageLayout::eColorAttachmentOptimal)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(swapchain_->GetSwapchainImage(current_image_index_))
+        .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+    barriers[1]
+        .setSrcAccessMask(vk::AccessFlagBits::eNone)
+        .setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setOldLayout(vk::ImageLayout::eUndefined)
+        .setNewLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(GetCurrentDepthImage().Image())
+        .setSubresourceRange({GetCurrentDepthImage().Aspect(), 0, 1, 0, 1});
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests, {}, nullptr, nullptr, barriers);
+
+    vk::RenderingAttachmentInfo color_attachment{};
+    color_attachment
+        .setImageView(swapchain_->GetSwapchainImageView(current_image_index_))
+        .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
+        .setLoadOp(vk::AttachmentLoadOp::eClear)
+        .setStoreOp(vk::AttachmentStoreOp::eStore)
+        .setClearValue(vk::ClearColorValue(CLEAR_COLOR));
+    vk::RenderingAttachmentInfo depth_attachment{};
+    depth_attachment
+        .setImageView(GetCurrentDepthImage().View())
+        .setImageLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
+        .setLoadOp(vk::AttachmentLoadOp::eClear)
+        .setStoreOp(swapchain_->GetDepthStoreOp())
+        .setClearValue(vk::ClearDepthStencilValue(1.0F, 0));
+    vk::RenderingInfo rendering_info{};
+    rendering_info
+        .setRenderArea({{0, 0}, swapchain_->GetSwapchainExtent()})
+        .setLayerCount(1)
+        .setColorAttachments(color_attachment)
+        .setPDepthAttachment(&depth_attachment);
+    command_buffer.beginRendering(rendering_info, device_->GetDispatcher());
 }
 
-void BVulkanRender::CreateCommandBuffers() {
-    command_buffers_.resize(swapchain_->GetImageCount());
-    vk::CommandBufferAllocateInfo alloc_info{};
-    alloc_info
-        .setLevel(vk::CommandBufferLevel::ePrimary)
-        .setCommandPool(device_->GetCommandPool())
-        .setCommandBufferCount(static_cast<uint32_t>(command_buffers_.size()));
-    command_buffers_ = device_->Device().allocateCommandBuffers(alloc_info);
+void BVulkanRender::EndDynamicRendering(vk::CommandBuffer command_buffer) {
+    command_buffer.endRendering(device_->GetDispatcher());
+    vk::ImageMemoryBarrier present_barrier{};
+    present_barrier
+        .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+        .setDstAccessMask(vk::AccessFlagBits::eNone)
+        .setOldLayout(vk::ImageLayout::eColorAttachmentOptimal)
+        .setNewLayout(vk::ImageLayout::ePresentSrcKHR)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(swapchain_->GetSwapchainImage(current_image_index_))
+        .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, present_barrier);
 }
 
-void BVulkanRender::FreeCommandBuffers() {
-    device_->Device().freeCommandBuffers(device_->GetCommandPool(), command_buffers_);
+bool BVulkanRender::RecreateSwapchain() {
+    vk::Extent2D canvas_extent{static_cast<uint32_t>(canvas_->Width()), static_cast<uint32_t>(canvas_->Height())};
+    if (canvas_extent == canvas_extent_ && !swapchain_dirty_) {
+        if (depth_dirty_) {
+            swapchain_->RecreateDepthResources();
+            depth_dirty_ = false;
+        }
+        return true;
+    }
+    if (canvas_extent.width == 0 || canvas_extent.height == 0) {
+        return false;
+    }
+    swapchain_->Recreate(canvas_->Width(), canvas_->Height());
+    canvas_extent_ = canvas_extent;
+    swapchain_dirty_ = false;
+    depth_dirty_ = false;
+    return true;
 }
 
-bool BVulkanRender::IsFrameInProgress() const {
-    return false;
+void BVulkanRender::LimitFrameRate() {
+    if (frame_interval_ == Clock::duration::zero()) {
+        return;
+    }
+    auto now = Clock::now();
+    if (next_frame_time_ > now) {
+        std::this_thread::sleep_until(next_frame_time_ - LIMITER_SPIN_TIME);
+        while (Clock::now() < next_frame_time_) {
+            std::this_thread::yield();
+        }
+    }
+    next_frame_time_ = (std::max)(next_frame_time_, now) + frame_interval_;
 }
 
-vk::CommandBuffer BVulkanRender::GetCurrentCommandBuffer() const {
-    return command_buffers_[current_image_index_];
+bool BVulkanRender::IsFrameInProgress() const {
+    return false;
 }
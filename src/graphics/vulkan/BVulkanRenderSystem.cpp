@@ -6,40 +6,377 @@
 
 #include "BVulkanRenderSystem.h"
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
 #include "BVulkanDevice.h"
+#include "BVulkanFrameContext.h"
 #include "BVulkanPipeline.h"
+#include "BVulkanPipelineLayoutCache.h"
+#include "BVulkanUploader.h"
 
-BVulkanRenderSystem::BVulkanRenderSystem(BVulkanDevice* device, const vk::RenderPass& render_pass) : device_(device) {
+BVulkanRenderSystem::BVulkanRenderSystem(BVulkanDevice* device, const vk::RenderPass& render_pass, vk::Format color_format, vk::Format depth_format, size_t frame_count) : device_(device), render_pass_(render_pass), color_format_(color_format), depth_format_(depth_format) {
     CreatePipelineLayout();
-    pipeline_ = CreatePipeline("shaders/shader.vert.spv", "shaders/shader.frag.spv", vk::PrimitiveTopology::eTriangleList, render_pass);
+    for (size_t i = 0; i < VERTEX_FORMAT_COUNT; ++i) {
+        pipelines_.at(i) = CreatePipeline(vk::PrimitiveTopology::eTriangleList, static_cast<BVulkanModel::VertexFormat>(i));
+    }
+    const auto& features = device_->GetEnabledFeatures();
+    multi_draw_indirect_ = features.multiDrawIndirect && features.drawIndirectFirstInstance;
+    if (multi_draw_indirect_) {
+        cull_system_ = std::make_unique<BVulkanCullSystem>(device_, frame_count);
+    }
+    frustum_culler_ = std::make_unique<BVulkanFrustumCuller>();
 }
 
 BVulkanRenderSystem::~BVulkanRenderSystem() {
-    device_->Device().destroyPipelineLayout(pipeline_layout_);
-    pipeline_.reset();
+    cull_system_.reset();
+    for (auto& pipeline : pipelines_) {
+        pipeline.Wait();
+        pipeline = {};
+    }
+}
+
+void BVulkanRenderSystem::BeginFrame(BVulkanFrameContext& frame) {
+    frame_ = &frame;
+    if (cull_system_) {
+        cull_system_->BeginFrame(frame.GetIndex());
+    }
+}
+
+void BVulkanRenderSystem::SetViewProjection(const glm::mat4& view_projection) {
+    view_projection_ = view_projection;
+}
+
+void BVulkanRenderSystem::SetLight(const glm::vec3& direction_to_light, const glm::vec3& light_color, const glm::vec3& ambient_color) {
+    frame_data_.direction_to_light_ = glm::vec4(glm::normalize(direction_to_light), 0.0F);
+    frame_data_.light_color_ = glm::vec4(light_color, 1.0F);
+    frame_data_.ambient_color_ = glm::vec4(ambient_color, 1.0F);
+}
+
+void BVulkanRenderSystem::SetDrawMode(DrawMode draw_mode) {
+    draw_mode_ = draw_mode;
+}
+
+void BVulkanRenderSystem::SetAlphaTest(bool alpha_test, float alpha_cutoff) {
+    fragment_specialization_.alpha_test_ = alpha_test ? VK_TRUE : VK_FALSE;
+    fragment_specialization_.alpha_cutoff_ = alpha_cutoff;
+    ResetPipelines();
+}
+
+void BVulkanRenderSystem::SetRasterState(const RasterState& raster_state) {
+    raster_state_ = raster_state;
+    if (!device_->HasExtendedDynamicState()) {
+        ResetPipelines();
+    }
+}
+
+void BVulkanRenderSystem::SetAttachmentFormats(const vk::RenderPass& render_pass, vk::Format color_format, vk::Format depth_format) {
+    if (render_pass == render_pass_ && color_format == color_format_ && depth_format == depth_format_) {
+        return;
+    }
+    auto compatible = color_format == color_format_ && depth_format == depth_format_;
+    render_pass_ = render_pass;
+    color_format_ = color_format;
+    depth_format_ = depth_format;
+    ResetPipelines(compatible);
+}
+
+void BVulkanRenderSystem::SetCullMode(CullMode cull_mode) {
+    cull_mode_ = cull_mode;
+    if (cull_system_) {
+        cull_system_->SetOcclusion(cull_mode_ == CullMode::eFrustumOcclusion);
+    }
+}
+
+bool BVulkanRenderSystem::UsesDepthPyramid() const {
+    return cull_system_ && cull_mode_ == CullMode::eFrustumOcclusion;
+}
+
+void BVulkanRenderSystem::PrepareObjects(vk::CommandBuffer& command_buffer, const std::vector<RenderObject>& objects) {
+    device_->GetUploader().Flush();
+    device_->GetUploader().RecordAcquires(command_buffer, frame_->GetUploadSemaphores(), frame_->GetUploadWaitValues(), frame_->GetUploadWaitStages());
+    sorted_objects_.clear();
+    batches_.clear();
+    cull_objects_.clear();
+    culling_ = cull_system_ && cull_mode_ != CullMode::eNone && draw_mode_ == DrawMode::eIndirect;
+    auto drawable = [](const RenderObject& object) {
+        return object.model_ != nullptr && !object.model_->IsEmpty();
+    };
+    auto gpu_culled = [this](const RenderObject& object) {
+        return culling_ && object.model_->IsIndexed();
+    };
+    auto cpu_culling = cull_mode_ != CullMode::eNone && std::any_of(objects.begin(), objects.end(), [&](const RenderObject& object) {
+        return drawable(object) && !gpu_culled(object);
+    });
+    if (cpu_culling) {
+        SyncFrustumCuller(objects);
+        frustum_culler_->Cull(view_projection_, visible_objects_);
+        for (auto handle : visible_objects_) {
+            const auto& object = objects[culler_objects_[handle]];
+            if (drawable(object) && !gpu_culled(object)) {
+                sorted_objects_.push_back(&object);
+            }
+        }
+    }
+    for (const auto& object : objects) {
+        if (drawable(object) && (!cpu_culling || gpu_culled(object))) {
+            sorted_objects_.push_back(&object);
+        }
+    }
+    if (sorted_objects_.empty()) {
+        return;
+    }
+    std::sort(sorted_objects_.begin(), sorted_objects_.end(), [](const RenderObject* lhs, const RenderObject* rhs) {
+        const auto* lhs_model = lhs->model_;
+        const auto* rhs_model = rhs->model_;
+        if (lhs_model->GetVertexFormat() != rhs_model->GetVertexFormat()) {
+            return lhs_model->GetVertexFormat() < rhs_model->GetVertexFormat();
+        }
+        if (lhs_model->GetVertexBuffer() != rhs_model->GetVertexBuffer()) {
+            return lhs_model->GetVertexBuffer() < rhs_model->GetVertexBuffer();
+        }
+        if (lhs_model->IsIndexed() != rhs_model->IsIndexed()) {
+            return lhs_model->IsIndexed();
+        }
+        if (lhs_model->IsIndexed() && lhs_model->GetIndexBuffer() != rhs_model->GetIndexBuffer()) {
+            return lhs_model->GetIndexBuffer() < rhs_model->GetIndexBuffer();
+        }
+        return lhs_model < rhs_model;
+    });
+
+    auto instance_size = sizeof(BVulkanModel::Instance) * sorted_objects_.size();
+    instances_ = frame_->GetUploadArena().Allocate(instance_size, BVulkanRingBuffer::FRAME_ALIGNMENT);
+    auto* instance_data = static_cast<BVulkanModel::Instance*>(instances_.mapped_);
+    for (size_t i = 0; i < sorted_objects_.size(); ++i) {
+        const auto& object = *sorted_objects_[i];
+        const auto& dequantization = object.model_->GetDequantization();
+        instance_data[i].transform_ = object.transform_;
+        instance_data[i].color_ = object.color_;
+        instance_data[i].dequantization_scale_ = glm::vec4(dequantization[0][0], dequantization[1][1], dequantization[2][2], 1.0F);
+        instance_data[i].dequantization_offset_ = glm::vec4(glm::vec3(dequantization[3]), 0.0F);
+        instance_data[i].normal_matrix_ = glm::mat3x4(glm::transpose(glm::inverse(glm::mat3(object.transform_))));
+    }
+
+    auto command_size = sizeof(vk::DrawIndexedIndirectCommand) * sorted_objects_.size();
+    commands_ = frame_->GetUploadArena().Allocate(command_size, BVulkanRingBuffer::FRAME_ALIGNMENT);
+    auto* command_data = static_cast<vk::DrawIndexedIndirectCommand*>(commands_.mapped_);
+    uint32_t command_count = 0;
+    size_t first = 0;
+    while (first < sorted_objects_.size()) {
+        const auto* model = sorted_objects_[first]->model_;
+        auto last = first + 1;
+        while (last < sorted_objects_.size() && sorted_objects_[last]->model_ == model) {
+            ++last;
+        }
+        auto* pipeline = GetPipeline(model->GetVertexFormat());
+        if (pipeline == nullptr) {
+            first = last;
+            continue;
+        }
+        if (!model->IsIndexed()) {
+            batches_.push_back({pipeline, model, static_cast<uint32_t>(first), static_cast<uint32_t>(last - first)});
+            first = last;
+            continue;
+        }
+        if (batches_.empty() || !batches_.back().model_->IsIndexed() || batches_.back().pipeline_ != pipeline || batches_.back().model_->GetVertexBuffer() != model->GetVertexBuffer() || batches_.back().model_->GetIndexBuffer() != model->GetIndexBuffer()) {
+            batches_.push_back({pipeline, model, command_count, 0});
+        }
+        if (culling_) {
+            const auto& sphere = model->GetBoundingSphere();
+            for (auto instance = first; instance < last; ++instance) {
+                BVulkanCullSystem::CullObject object{};
+                object.sphere_ = sphere;
+                object.instance_ = static_cast<uint32_t>(instance);
+                object.command_ = command_count;
+                object.first_instance_ = static_cast<uint32_t>(first);
+                cull_objects_.push_back(object);
+            }
+        }
+        command_data[command_count++] = model->GetDrawCommand(culling_ ? 0 : static_cast<uint32_t>(last - first), static_cast<uint32_t>(first));
+        ++batches_.back().count_;
+        first = last;
+    }
+    if (culling_) {
+        cull_system_->Cull(command_buffer, view_projection_, instances_, instance_size, commands_, command_size, cull_objects_);
+    }
+}
+
+void BVulkanRenderSystem::RenderObjects(vk::CommandBuffer& command_buffer) {
+    if (batches_.empty()) {
+        return;
+    }
+    PushConstantData push{};
+    push.view_projection_ = view_projection_;
+    command_buffer.pushConstants(pipeline_layout_, push_constant_stages_, 0, sizeof(PushConstantData), &push);
+    BindFrameData(command_buffer);
+    SetDynamicState(command_buffer);
+
+    BVulkanPipeline* bound_pipeline{nullptr};
+    vk::Buffer bound_vertex_buffer{};
+    vk::Buffer bound_index_buffer{};
+    vk::Buffer bound_instance_buffer{};
+    for (const auto& batch : batches_) {
+        const auto* model = batch.model_;
+        if (culling_ && model->IsIndexed()) {
+            if (cull_system_->GetInstanceBuffer() != bound_instance_buffer) {
+                command_buffer.bindVertexBuffers(BVulkanModel::INSTANCE_BINDING, cull_system_->GetInstanceBuffer(), vk::DeviceSize{0});
+                bound_instance_buffer = cull_system_->GetInstanceBuffer();
+            }
+        } else if (instances_.buffer_ != bound_instance_buffer) {
+            command_buffer.bindVertexBuffers(BVulkanModel::INSTANCE_BINDING, instances_.buffer_, instances_.offset_);
+            bound_instance_buffer = instances_.buffer_;
+        }
+        if (batch.pipeline_ != bound_pipeline) {
+            batch.pipeline_->Bind(command_buffer);
+            bound_pipeline = batch.pipeline_;
+        }
+        if (model->GetVertexBuffer() != bound_vertex_buffer) {
+            command_buffer.bindVertexBuffers(0, model->GetVertexBuffer(), {0});
+            bound_vertex_buffer = model->GetVertexBuffer();
+        }
+        if (!model->IsIndexed()) {
+            model->Draw(command_buffer, batch.count_, batch.first_);
+            continue;
+        }
+        if (model->GetIndexBuffer() != bound_index_buffer) {
+            command_buffer.bindIndexBuffer(model->GetIndexBuffer(), 0, model->GetIndexType());
+            bound_index_buffer = model->GetIndexBuffer();
+        }
+        DrawBatch(command_buffer, batch);
+    }
 }
 
-void BVulkanRenderSystem::RenderObjects(vk::CommandBuffer& command_buffer, const std::vector<BVulkanModel>& models) {
-    pipeline_->Bind(command_buffer);
-    for (auto& model : models) {
-        model.Bind(command_buffer);
-        model.Draw(command_buffer);
+void BVulkanRenderSystem::BuildDepthPyramid(vk::CommandBuffer& command_buffer, const BVulkanImage& depth_image, const vk::Extent2D& depth_extent) {
+    if (UsesDepthPyramid()) {
+        cull_system_->BuildDepthPyramid(command_buffer, depth_image, depth_extent, view_projection_);
     }
 }
 
 void BVulkanRenderSystem::CreatePipelineLayout() {
-    vk::PipelineLayoutCreateInfo pipeline_info{};
-    pipeline_info
-        .setSetLayoutCount(0)
-        .setPSetLayouts(nullptr)
-        .setPushConstantRangeCount(0)
-        .setPushConstantRanges(nullptr);
-    pipeline_layout_ = device_->Device().createPipelineLayout(pipeline_info);
+    const auto& layout = device_->GetPipelineLayoutCache().GetLayout({"shader.vert", "shader.frag"}, {{FRAME_DATA_SET, FRAME_DATA_BINDING}});
+    if (layout.push_constant_size_ < sizeof(PushConstantData)) {
+        throw std::runtime_error("Shader push constant block is smaller than PushConstantData.");
+    }
+    pipeline_layout_ = layout.pipeline_layout_;
+    push_constant_stages_ = layout.push_constant_stages_;
+    frame_set_layout_ = layout.set_layouts_.at(FRAME_DATA_SET);
+}
+
+void BVulkanRenderSystem::BindFrameData(vk::CommandBuffer& command_buffer) {
+    auto allocation = frame_->GetUniformArena().Allocate(sizeof(FrameData), BVulkanRingBuffer::FRAME_ALIGNMENT);
+    std::memcpy(allocation.mapped_, &frame_data_, sizeof(FrameData));
+    auto frame_set = frame_->AllocateDescriptorSet(frame_set_layout_);
+    vk::DescriptorBufferInfo buffer_info(allocation.buffer_, 0, sizeof(FrameData));
+    vk::WriteDescriptorSet write{};
+    write
+        .setDstSet(frame_set)
+        .setDstBinding(FRAME_DATA_BINDING)
+        .setDescriptorCount(1)
+        .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+        .setBufferInfo(buffer_info);
+    device_->Device().updateDescriptorSets(write, nullptr);
+    auto dynamic_offset = static_cast<uint32_t>(allocation.offset_);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout_, FRAME_DATA_SET, frame_set, dynamic_offset);
 }
 
-std::unique_ptr<BVulkanPipeline> BVulkanRenderSystem::CreatePipeline(const std::string& vert_shader_path, const std::string& frag_shader_path, vk::PrimitiveTopology primitive_topology, const vk::RenderPass& render_pass) {
+BVulkanPipelineRegistry::Handle BVulkanRenderSystem::CreatePipeline(vk::PrimitiveTopology primitive_topology, BVulkanModel::VertexFormat vertex_format, const BVulkanPipelineRegistry::Handle& fallback) {
     auto pipeline_config = BVulkanPipeline::DefaultPipelineConfigInfo(primitive_topology);
-    pipeline_config.render_pass_ = render_pass;
+    pipeline_config.binding_descriptions_ = BVulkanModel::GetBindingDescriptions(vertex_format);
+    pipeline_config.attribute_descriptions_ = BVulkanModel::GetAttributeDescriptions(vertex_format);
+    pipeline_config.render_pass_ = render_pass_;
+    pipeline_config.color_attachment_format_ = color_format_;
+    pipeline_config.depth_attachment_format_ = depth_format_;
     pipeline_config.pipeline_layout_ = pipeline_layout_;
-    return std::make_unique<BVulkanPipeline>(device_, vert_shader_path, frag_shader_path, pipeline_config);
+    pipeline_config.rasterization_info_.setCullMode(raster_state_.cull_mode_).setFrontFace(raster_state_.front_face_);
+    pipeline_config.depth_stencil_info_.setDepthTestEnable(raster_state_.depth_test_).setDepthWriteEnable(raster_state_.depth_write_).setDepthCompareOp(raster_state_.depth_compare_op_);
+    if (device_->HasExtendedDynamicState()) {
+        BVulkanPipeline::EnableExtendedDynamicState(pipeline_config);
+    }
+    VertexSpecialization vertex_specialization{};
+    vertex_specialization.octahedral_normal_ = vertex_format == BVulkanModel::VertexFormat::eFloat ? VK_FALSE : VK_TRUE;
+    pipeline_config.vert_specialization_ = BVulkanPipeline::MakeSpecializationInfo(vertex_specialization, VERTEX_CONSTANT_ID);
+    pipeline_config.frag_specialization_ = BVulkanPipeline::MakeSpecializationInfo(fragment_specialization_, FRAGMENT_CONSTANT_ID);
+    return device_->GetPipelineRegistry().Acquire("shader.vert", "shader.frag", pipeline_config, fallback);
+}
+
+BVulkanPipeline* BVulkanRenderSystem::GetPipeline(BVulkanModel::VertexFormat vertex_format) {
+    auto& pipeline = pipelines_.at(static_cast<size_t>(vertex_format));
+    if (!pipeline) {
+        pipeline = CreatePipeline(vk::PrimitiveTopology::eTriangleList, vertex_format);
+    }
+    if (pipeline.Get() == nullptr) {
+        pipeline.Wait();
+    }
+    return pipeline.Get();
+}
+
+void BVulkanRenderSystem::ResetPipelines(bool compatible) {
+    for (size_t i = 0; i < VERTEX_FORMAT_COUNT; ++i) {
+        auto& pipeline = pipelines_.at(i);
+        pipeline = CreatePipeline(vk::PrimitiveTopology::eTriangleList, static_cast<BVulkanModel::VertexFormat>(i), compatible ? pipeline : BVulkanPipelineRegistry::Handle{});
+    }
+}
+
+void BVulkanRenderSystem::SetDynamicState(vk::CommandBuffer& command_buffer) const {
+    if (!device_->HasExtendedDynamicState()) {
+        return;
+    }
+    const auto& dispatcher = device_->GetDispatcher();
+    command_buffer.setCullMode(raster_state_.cull_mode_, dispatcher);
+    command_buffer.setFrontFace(raster_state_.front_face_, dispatcher);
+    command_buffer.setPrimitiveTopology(vk::PrimitiveTopology::eTriangleList, dispatcher);
+    command_buffer.setDepthTestEnable(raster_state_.depth_test_, dispatcher);
+    command_buffer.setDepthWriteEnable(raster_state_.depth_write_, dispatcher);
+    command_buffer.setDepthCompareOp(raster_state_.depth_compare_op_, dispatcher);
+    command_buffer.setDepthBoundsTestEnable(false, dispatcher);
+}
+
+void BVulkanRenderSystem::SyncFrustumCuller(const std::vector<RenderObject>& objects) {
+    auto insert = [this](size_t index, const RenderObject& object) {
+        auto bounds = object.model_ != nullptr ? object.model_->GetBoundingBox() : BVulkanModel::BoundingBox{};
+        auto handle = frustum_culler_->Insert(bounds.min_, bounds.max_, object.transform_);
+        if (handle >= culler_objects_.size()) {
+            culler_objects_.resize(handle + 1);
+        }
+        culler_objects_[handle] = static_cast<uint32_t>(index);
+        culler_handles_[index] = handle;
+        culler_models_[index] = object.model_;
+    };
+    if (objects.size() != culler_handles_.size()) {
+        frustum_culler_->Clear();
+        culler_objects_.clear();
+        culler_handles_.resize(objects.size());
+        culler_models_.resize(objects.size());
+        for (size_t i = 0; i < objects.size(); ++i) {
+            insert(i, objects[i]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const auto& object = objects[i];
+        auto handle = culler_handles_[i];
+        if (object.model_ != culler_models_[i]) {
+            frustum_culler_->Remove(handle);
+            insert(i, object);
+        } else if (object.transform_ != frustum_culler_->GetTransform(handle)) {
+            frustum_culler_->Update(handle, object.transform_);
+        }
+    }
+}
+
+void BVulkanRenderSystem::DrawBatch(vk::CommandBuffer& command_buffer, const Batch& batch) const {
+    if (batch.count_ == 0) {
+        return;
+    }
+    constexpr auto stride = static_cast<uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
+    if (culling_ || (draw_mode_ == DrawMode::eIndirect && multi_draw_indirect_)) {
+        command_buffer.drawIndexedIndirect(commands_.buffer_, commands_.offset_ + vk::DeviceSize{stride} * batch.first_, batch.count_, stride);
+        return;
+    }
+    const auto* command_data = static_cast<const vk::DrawIndexedIndirectCommand*>(commands_.mapped_);
+    for (auto i = batch.first_; i < batch.first_ + batch.count_; ++i) {
+        const auto& command = command_data[i];
+        command_buffer.drawIndexed(command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+    }
 }
@@ -0,0 +1,45 @@
+/**
+ * @file BVulkanRingBuffer.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-13
+ */
+
+#include "BVulkanRingBuffer.h"
+
+#include <algorithm>
+
+#include "BVulkanDevice.h"
+
+BVulkanRingBuffer::BVulkanRingBuffer(BVulkanDevice* device, vk::DeviceSize frame_size, vk::BufferUsageFlags usage, size_t frame_count) : device_(device), usage_(usage), frame_count_(frame_count) {
+    Grow(frame_size);
+}
+
+void BVulkanRingBuffer::BeginFrame(size_t frame_index) {
+    frame_index_ = frame_index % frame_count_;
+    head_ = 0;
+}
+
+BVulkanRingBuffer::Allocation BVulkanRingBuffer::Allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+    alignment = (std::max)(alignment, vk::DeviceSize{1});
+    auto offset = (head_ + alignment - 1) / alignment * alignment;
+    if (offset + size > frame_size_) {
+        Grow((std::max)(frame_size_ * 2, size));
+        offset = 0;
+    }
+    head_ = offset + size;
+    Allocation allocation{};
+    allocation.buffer_ = buffer_.Buffer();
+    allocation.offset_ = frame_size_ * frame_index_ + offset;
+    allocation.mapped_ = static_cast<char*>(buffer_.Mapped()) + allocation.offset_;
+    return allocation;
+}
+
+const vk::Buffer& BVulkanRingBuffer::Buffer() const {
+    return buffer_.Buffer();
+}
+
+void BVulkanRingBuffer::Grow(vk::DeviceSize minimum_frame_size) {
+    frame_size_ = (minimum_frame_size + FRAME_ALIGNMENT - 1) / FRAME_ALIGNMENT * FRAME_ALIGNMENT;
+    buffer_ = BVulkanBuffer(device_, frame_size_ * frame_count_, usage_, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+    head_ = 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file BVulkanShaderLibrary.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-17
+ */
+
+#include "BVulkanShaderLibrary.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "BVulkanEmbeddedShaders.h"
+
+namespace {
+
+std::string ReadEnvironmentVariable(const char* name) {
+#if defined(_WIN32)
+    char* value{nullptr};
+    size_t size{0};
+    if (_dupenv_s(&value, &size, name) != 0 || value == nullptr) {
+        return {};
+    }
+    std::string result{value};
+    free(value);
+    return result;
+#else
+    const auto* value = std::getenv(name);
+    return value == nullptr ? std::string{} : std::string{value};
+#endif
+}
+
+}  // namespace
+
+BVulkanShaderLibrary::BVulkanShaderLibrary() : override_directory_(ReadEnvironmentVariable(SHADER_DIRECTORY_VARIABLE)) {
+#if !defined(NOT_DEBUG)
+    if (HasOverride()) {
+        std::cerr << "[INFO] Loading shaders from " << override_directory_ << "." << std::endl;
+    }
+#endif
+}
+
+std::span<const uint32_t> BVulkanShaderLibrary::GetShader(const std::string& name) {
+    if (HasOverride()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = overrides_.find(name);
+        if (iter != overrides_.end()) {
+            return iter->second;
+        }
+        auto path = std::filesystem::path(override_directory_) / (name + ".spv");
+        if (std::filesystem::exists(path)) {
+            return overrides_.emplace(name, ReadFile(path.string())).first->second;
+        }
+    }
+    for (const auto& shader : EMBEDDED_SHADERS) {
+        if (shader.name_ == name) {
+            return shader.code_;
+        }
+    }
+    throw std::runtime_error("Unknown shader: " + name + ".");
+}
+
+const BVulkanShaderReflection& BVulkanShaderLibrary::GetReflection(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = reflections_.find(name);
+        if (iter != reflections_.end()) {
+            return *iter->second;
+        }
+    }
+    auto reflection = std::make_unique<BVulkanShaderReflection>(GetShader(name));
+    std::lock_guard<std::mutex> lock(mutex_);
+    return *reflections_.try_emplace(name, std::move(reflection)).first->second;
+}
+
+bool BVulkanShaderLibrary::HasOverride() const {
+    return !override_directory_.empty();
+}
+
+std::vector<uint32_t> BVulkanShaderLibrary::ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + path + ".");
+    }
+    auto file_size = static_cast<size_t>(file.tellg());
+    if (file_size == 0 || file_size % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("Invalid SPIR-V file: " + path + ".");
+    }
+    std::vector<uint32_t> buffer(file_size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(file_size));
+    file.close();
+    return buffer;
+}
@@ -0,0 +1,431 @@
+/**
+ * @file BVulkanShaderReflection.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-18
+ */
+
+#include "BVulkanShaderReflection.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t SPIRV_MAGIC{0x07230203};
+constexpr size_t SPIRV_HEADER_SIZE{5};
+constexpr uint32_t INVALID_LOCATION{0xFFFFFFFF};
+
+enum Op : uint32_t {
+    eOpEntryPoint = 15,
+    eOpTypeBool = 20,
+    eOpTypeInt = 21,
+    eOpTypeFloat = 22,
+    eOpTypeVector = 23,
+    eOpTypeMatrix = 24,
+    eOpTypeImage = 25,
+    eOpTypeSampler = 26,
+    eOpTypeSampledImage = 27,
+    eOpTypeArray = 28,
+    eOpTypeRuntimeArray = 29,
+    eOpTypeStruct = 30,
+    eOpTypePointer = 32,
+    eOpConstant = 43,
+    eOpSpecConstant = 50,
+    eOpVariable = 59,
+    eOpDecorate = 71,
+    eOpMemberDecorate = 72,
+};
+
+enum Decoration : uint32_t {
+    eDecorationBufferBlock = 3,
+    eDecorationArrayStride = 6,
+    eDecorationMatrixStride = 7,
+    eDecorationBuiltIn = 11,
+    eDecorationLocation = 30,
+    eDecorationBinding = 33,
+    eDecorationDescriptorSet = 34,
+    eDecorationOffset = 35,
+};
+
+enum StorageClass : uint32_t {
+    eStorageClassUniformConstant = 0,
+    eStorageClassInput = 1,
+    eStorageClassUniform = 2,
+    eStorageClassPushConstant = 9,
+    eStorageClassStorageBuffer = 12,
+};
+
+constexpr uint32_t DIM_BUFFER{5};
+constexpr uint32_t DIM_SUBPASS_DATA{6};
+constexpr uint32_t IMAGE_STORAGE{2};
+
+struct Decorations {
+    uint32_t location_{INVALID_LOCATION};
+    uint32_t binding_{INVALID_LOCATION};
+    uint32_t set_{0};
+    uint32_t array_stride_{0};
+    bool built_in_{false};
+    bool buffer_block_{false};
+};
+
+struct Variable {
+    uint32_t id_{0};
+    uint32_t type_{0};
+    uint32_t storage_class_{0};
+};
+
+struct Module {
+    uint32_t execution_model_{INVALID_LOCATION};
+    std::unordered_map<uint32_t, std::vector<uint32_t>> types_{};
+    std::unordered_map<uint32_t, uint32_t> constants_{};
+    std::unordered_map<uint32_t, Decorations> decorations_{};
+    std::unordered_map<uint32_t, std::vector<uint32_t>> member_offsets_{};
+    std::unordered_map<uint64_t, uint32_t> matrix_strides_{};
+    std::vector<Variable> variables_{};
+
+    const std::vector<uint32_t>& GetType(uint32_t id) const {
+        auto iter = types_.find(id);
+        if (iter == types_.end()) {
+            throw std::runtime_error("Unknown SPIR-V type.");
+        }
+        return iter->second;
+    }
+
+    uint32_t GetConstant(uint32_t id) const {
+        auto iter = constants_.find(id);
+        if (iter == constants_.end()) {
+            throw std::runtime_error("Unknown SPIR-V constant.");
+        }
+        return iter->second;
+    }
+};
+
+Module ParseModule(std::span<const uint32_t> code) {
+    if (code.size() < SPIRV_HEADER_SIZE || code[0] != SPIRV_MAGIC) {
+        throw std::runtime_error("Invalid SPIR-V module.");
+    }
+    Module module{};
+    size_t offset = SPIRV_HEADER_SIZE;
+    while (offset < code.size()) {
+        auto word_count = code[offset] >> 16;
+        auto opcode = code[offset] & 0xFFFF;
+        if (word_count == 0 || offset + word_count > code.size()) {
+            throw std::runtime_error("Invalid SPIR-V instruction.");
+        }
+        auto words = code.subspan(offset, word_count);
+        switch (opcode) {
+            case eOpEntryPoint:
+                if (module.execution_model_ == INVALID_LOCATION) {
+                    module.execution_model_ = words[1];
+                }
+                break;
+            case eOpTypeBool:
+            case eOpTypeInt:
+            case eOpTypeFloat:
+            case eOpTypeVector:
+            case eOpTypeMatrix:
+            case eOpTypeImage:
+            case eOpTypeSampler:
+            case eOpTypeSampledImage:
+            case eOpTypeArray:
+            case eOpTypeRuntimeArray:
+            case eOpTypeStruct:
+            case eOpTypePointer:
+                module.types_[words[1]].assign(words.begin(), words.end());
+                break;
+            case eOpConstant:
+            case eOpSpecConstant:
+                module.constants_[words[2]] = words[3];
+                break;
+            case eOpVariable:
+                module.variables_.push_back({words[2], words[1], words[3]});
+                break;
+            case eOpDecorate: {
+                auto& decorations = module.decorations_[words[1]];
+                switch (words[2]) {
+                    case eDecorationBufferBlock:
+                        decorations.buffer_block_ = true;
+                        break;
+                    case eDecorationArrayStride:
+                        decorations.array_stride_ = words[3];
+                        break;
+                    case eDecorationBuiltIn:
+                        decorations.built_in_ = true;
+                        break;
+                    case eDecorationLocation:
+                        decorations.location_ = words[3];
+                        break;
+                    case eDecorationBinding:
+                        decorations.binding_ = words[3];
+                        break;
+                    case eDecorationDescriptorSet:
+                        decorations.set_ = words[3];
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            }
+            case eOpMemberDecorate:
+                if (words[3] == eDecorationOffset) {
+                    auto& offsets = module.member_offsets_[words[1]];
+                    offsets.resize((std::max)(offsets.size(), static_cast<size_t>(words[2]) + 1), INVALID_LOCATION);
+                    offsets[words[2]] = words[4];
+                } else if (words[3] == eDecorationMatrixStride) {
+                    module.matrix_strides_[(static_cast<uint64_t>(words[1]) << 32) | words[2]] = words[4];
+                } else if (words[3] == eDecorationBuiltIn) {
+                    module.decorations_[words[1]].built_in_ = true;
+                }
+                break;
+            default:
+                break;
+        }
+        offset += word_count;
+    }
+    return module;
+}
+
+uint32_t SizeOf(const Module& module, uint32_t type_id, uint32_t matrix_stride = 0) {
+    const auto& type = module.GetType(type_id);
+    switch (type[0] & 0xFFFF) {
+        case eOpTypeBool:
+            return 4;
+        case eOpTypeInt:
+        case eOpTypeFloat:
+            return type[2] / 8;
+        case eOpTypeVector:
+            return type[3] * SizeOf(module, type[2]);
+        case eOpTypeMatrix:
+            return type[3] * (matrix_stride != 0 ? matrix_stride : SizeOf(module, type[2]));
+        case eOpTypeArray: {
+            auto iter = module.decorations_.find(type_id);
+            auto stride = iter != module.decorations_.end() && iter->second.array_stride_ != 0 ? iter->second.array_stride_ : SizeOf(module, type[2]);
+            return module.GetConstant(type[3]) * stride;
+        }
+        case eOpTypeRuntimeArray:
+            return 0;
+        case eOpTypeStruct: {
+            auto offsets = module.member_offsets_.find(type_id);
+            uint32_t size = 0;
+            for (uint32_t member = 0; member + 2 < type.size(); ++member) {
+                auto member_offset = size;
+                if (offsets != module.member_offsets_.end() && member < offsets->second.size() && offsets->second[member] != INVALID_LOCATION) {
+                    member_offset = offsets->second[member];
+                }
+                auto stride = module.matrix_strides_.find((static_cast<uint64_t>(type_id) << 32) | member);
+                auto member_size = SizeOf(module, type[member + 2], stride != module.matrix_strides_.end() ? stride->second : 0);
+                size = (std::max)(size, member_offset + member_size);
+            }
+            return size;
+        }
+        default:
+            throw std::runtime_error("Unsupported SPIR-V type in a block.");
+    }
+}
+
+BVulkanShaderReflection::BaseType GetBaseType(const Module& module, uint32_t type_id) {
+    const auto& type = module.GetType(type_id);
+    switch (type[0] & 0xFFFF) {
+        case eOpTypeFloat:
+            return BVulkanShaderReflection::BaseType::eFloat;
+        case eOpTypeInt:
+            return type[3] != 0 ? BVulkanShaderReflection::BaseType::eInt : BVulkanShaderReflection::BaseType::eUint;
+        case eOpTypeVector:
+        case eOpTypeMatrix:
+            return GetBaseType(module, type[2]);
+        default:
+            throw std::runtime_error("Unsupported SPIR-V vertex input type.");
+    }
+}
+
+void AddVertexInputs(const Module& module, uint32_t type_id, uint32_t location, std::vector<BVulkanShaderReflection::VertexInput>& inputs) {
+    const auto& type = module.GetType(type_id);
+    switch (type[0] & 0xFFFF) {
+        case eOpTypeArray: {
+            auto length = module.GetConstant(type[3]);
+            const auto& element = module.GetType(type[2]);
+            auto element_locations = (element[0] & 0xFFFF) == eOpTypeMatrix ? element[3] : 1;
+            for (uint32_t i = 0; i < length; ++i) {
+                AddVertexInputs(module, type[2], location + i * element_locations, inputs);
+            }
+            break;
+        }
+        case eOpTypeMatrix: {
+            const auto& column = module.GetType(type[2]);
+            for (uint32_t i = 0; i < type[3]; ++i) {
+                inputs.push_back({location + i, GetBaseType(module, type[2]), column[3]});
+            }
+            break;
+        }
+        case eOpTypeVector:
+            inputs.push_back({location, GetBaseType(module, type_id), type[3]});
+            break;
+        default:
+            inputs.push_back({location, GetBaseType(module, type_id), 1});
+            break;
+    }
+}
+
+vk::DescriptorType GetDescriptorType(const Module& module, const std::vector<uint32_t>& type, uint32_t type_id, uint32_t storage_class) {
+    switch (type[0] & 0xFFFF) {
+        case eOpTypeStruct: {
+            if (storage_class == eStorageClassStorageBuffer) {
+                return vk::DescriptorType::eStorageBuffer;
+            }
+            auto iter = module.decorations_.find(type_id);
+            return iter != module.decorations_.end() && iter->second.buffer_block_ ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBuffer;
+        }
+        case eOpTypeSampledImage:
+            return vk::DescriptorType::eCombinedImageSampler;
+        case eOpTypeSampler:
+            return vk::DescriptorType::eSampler;
+        case eOpTypeImage:
+            if (type[3] == DIM_BUFFER) {
+                return type[7] == IMAGE_STORAGE ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+            }
+            if (type[3] == DIM_SUBPASS_DATA) {
+                return vk::DescriptorType::eInputAttachment;
+            }
+            return type[7] == IMAGE_STORAGE ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+        default:
+            throw std::runtime_error("Unsupported SPIR-V descriptor type.");
+    }
+}
+
+vk::ShaderStageFlagBits GetExecutionStage(uint32_t execution_model) {
+    switch (execution_model) {
+        case 0:
+            return vk::ShaderStageFlagBits::eVertex;
+        case 1:
+            return vk::ShaderStageFlagBits::eTessellationControl;
+        case 2:
+            return vk::ShaderStageFlagBits::eTessellationEvaluation;
+        case 3:
+            return vk::ShaderStageFlagBits::eGeometry;
+        case 4:
+            return vk::ShaderStageFlagBits::eFragment;
+        case 5:
+            return vk::ShaderStageFlagBits::eCompute;
+        default:
+            throw std::runtime_error("Unsupported SPIR-V execution model.");
+    }
+}
+
+BVulkanShaderReflection::BaseType GetFormatBaseType(vk::Format format) {
+    switch (format) {
+        case vk::Format::eR8Uint:
+        case vk::Format::eR8G8Uint:
+        case vk::Format::eR8G8B8Uint:
+        case vk::Format::eR8G8B8A8Uint:
+        case vk::Format::eR16Uint:
+        case vk::Format::eR16G16Uint:
+        case vk::Format::eR16G16B16Uint:
+        case vk::Format::eR16G16B16A16Uint:
+        case vk::Format::eR32Uint:
+        case vk::Format::eR32G32Uint:
+        case vk::Format::eR32G32B32Uint:
+        case vk::Format::eR32G32B32A32Uint:
+        case vk::Format::eA2B10G10R10UintPack32:
+            return BVulkanShaderReflection::BaseType::eUint;
+        case vk::Format::eR8Sint:
+        case vk::Format::eR8G8Sint:
+        case vk::Format::eR8G8B8Sint:
+        case vk::Format::eR8G8B8A8Sint:
+        case vk::Format::eR16Sint:
+        case vk::Format::eR16G16Sint:
+        case vk::Format::eR16G16B16Sint:
+        case vk::Format::eR16G16B16A16Sint:
+        case vk::Format::eR32Sint:
+        case vk::Format::eR32G32Sint:
+        case vk::Format::eR32G32B32Sint:
+        case vk::Format::eR32G32B32A32Sint:
+        case vk::Format::eA2B10G10R10SintPack32:
+            return BVulkanShaderReflection::BaseType::eInt;
+        default:
+            return BVulkanShaderReflection::BaseType::eFloat;
+    }
+}
+
+}  // namespace
+
+BVulkanShaderReflection::BVulkanShaderReflection(std::span<const uint32_t> code) {
+    auto module = ParseModule(code);
+    stage_ = GetExecutionStage(module.execution_model_);
+    for (const auto& variable : module.variables_) {
+        const auto& pointer = module.GetType(variable.type_);
+        auto type_id = pointer[3];
+        auto decorations = module.decorations_.find(variable.id_);
+        switch (variable.storage_class_) {
+            case eStorageClassInput:
+                if (stage_ == vk::ShaderStageFlagBits::eVertex && decorations != module.decorations_.end() && !decorations->second.built_in_ && decorations->second.location_ != INVALID_LOCATION) {
+                    AddVertexInputs(module, type_id, decorations->second.location_, vertex_inputs_);
+                }
+                break;
+            case eStorageClassUniformConstant:
+            case eStorageClassUniform:
+            case eStorageClassStorageBuffer: {
+                if (decorations == module.decorations_.end() || decorations->second.binding_ == INVALID_LOCATION) {
+                    break;
+                }
+                DescriptorBinding binding{};
+                binding.set_ = decorations->second.set_;
+                binding.binding_ = decorations->second.binding_;
+                const auto* type = &module.GetType(type_id);
+                while (((*type)[0] & 0xFFFF) == eOpTypeArray || ((*type)[0] & 0xFFFF) == eOpTypeRuntimeArray) {
+                    if (((*type)[0] & 0xFFFF) == eOpTypeRuntimeArray) {
+                        throw std::runtime_error("Unsized descriptor arrays are not supported.");
+                    }
+                    binding.count_ *= module.GetConstant((*type)[3]);
+                    type_id = (*type)[2];
+                    type = &module.GetType(type_id);
+                }
+                binding.type_ = GetDescriptorType(module, *type, type_id, variable.storage_class_);
+                descriptor_bindings_.push_back(binding);
+                break;
+            }
+            case eStorageClassPushConstant:
+                push_constant_size_ = (std::max)(push_constant_size_, SizeOf(module, type_id));
+                break;
+            default:
+                break;
+        }
+    }
+    std::sort(vertex_inputs_.begin(), vertex_inputs_.end(), [](const VertexInput& a, const VertexInput& b) {
+        return a.location_ < b.location_;
+    });
+    std::sort(descriptor_bindings_.begin(), descriptor_bindings_.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+        return a.set_ != b.set_ ? a.set_ < b.set_ : a.binding_ < b.binding_;
+    });
+}
+
+vk::ShaderStageFlagBits BVulkanShaderReflection::GetStage() const {
+    return stage_;
+}
+
+const std::vector<BVulkanShaderReflection::VertexInput>& BVulkanShaderReflection::GetVertexInputs() const {
+    return vertex_inputs_;
+}
+
+const std::vector<BVulkanShaderReflection::DescriptorBinding>& BVulkanShaderReflection::GetDescriptorBindings() const {
+    return descriptor_bindings_;
+}
+
+uint32_t BVulkanShaderReflection::GetPushConstantSize() const {
+    return push_constant_size_;
+}
+
+void BVulkanShaderReflection::ValidateVertexInput(const std::vector<vk::VertexInputAttributeDescription>& attributes) const {
+    for (const auto& input : vertex_inputs_) {
+        auto iter = std::find_if(attributes.begin(), attributes.end(), [&input](const vk::VertexInputAttributeDescription& attribute) {
+            return attribute.location == input.location_;
+        });
+        if (iter == attributes.end()) {
+            throw std::runtime_error("Vertex input location " + std::to_string(input.location_) + " has no attribute description.");
+        }
+        if (GetFormatBaseType(iter->format) != input.base_type_) {
+            throw std::runtime_error("Vertex input location " + std::to_string(input.location_) + " does not match its attribute format.");
+        }
+    }
+}
@@ -6,15 +6,26 @@
 
 #include "BVulkanSwapchain.h"
 
+#include <algorithm>
+#include <array>
+
 #include "BVulkanDevice.h"
+#include "BVulkanTimeline.h"
 
-BVulkanSwapchain::BVulkanSwapchain(BVulkanDevice* device, int width, int height) : device_(device) {
+BVulkanSwapchain::BVulkanSwapchain(BVulkanDevice* device, int width, int height, size_t frames_in_flight, const Config& config) : device_(device), frames_in_flight_(frames_in_flight) {
+    SetConfig(config);
+    depth_sampled_ = config_.sampled_depth_;
     canvas_extent_.setWidth(width);
     canvas_extent_.setHeight(height);
     CreateSwapchain();
-    CreateRenderPass();
+    depth_format_ = FindDepthFormat();
+    if (!device_->HasDynamicRendering()) {
+        CreateRenderPass();
+    }
     CreateDepthResources();
-    CreateFrameBuffers();
+    if (render_pass_) {
+        CreateFrameBuffers();
+    }
     CreateSyncObjects();
 }
 
@@ -27,18 +38,13 @@ BVulkanSwapchain::~BVulkanSwapchain() {
         device_->Device().destroySwapchainKHR(swapchain_);
         swapchain_ = nullptr;
     }
-    for (size_t i = 0; i < depth_images_.size(); ++i) {
-        device_->Device().destroyImageView(depth_image_views_[i]);
-        device_->Device().destroyImage(depth_images_[i]);
-        device_->Device().freeMemory(depth_image_memories_[i]);
-    }
+    depth_images_.clear();
     for (auto& framebuffer : swapchain_frame_buffers_) {
         device_->Device().destroyFramebuffer(framebuffer);
     }
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    for (size_t i = 0; i < frames_in_flight_; ++i) {
         device_->Device().destroySemaphore(render_finished_semaphores_[i]);
         device_->Device().destroySemaphore(image_available_semaphores_[i]);
-        device_->Device().destroyFence(in_flight_fences_[i]);
     }
     device_->Device().destroyRenderPass(render_pass_);
 }
@@ -55,35 +61,69 @@ const vk::RenderPass& BVulkanSwapchain::GetRenderPass() const {
     return render_pass_;
 }
 
+const vk::Format& BVulkanSwapchain::GetDepthFormat() const {
+    return depth_format_;
+}
+
+vk::AttachmentStoreOp BVulkanSwapchain::GetDepthStoreOp() const {
+    return depth_sampled_ ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+}
+
 float BVulkanSwapchain::GetExtentAspectRatio() const {
     return static_cast<float>(swapchain_extent_.width) / static_cast<float>(swapchain_extent_.height);
 }
 
-uint32_t BVulkanSwapchain::AcquireNextImage() {
-    [[maybe_unused]] auto res = device_->Device().waitForFences(in_flight_fences_[current_frame_], true, (std::numeric_limits<uint64_t>::max)());
-    return device_->Device().acquireNextImageKHR(swapchain_, (std::numeric_limits<uint64_t>::max)(), image_available_semaphores_[current_frame_], nullptr).value;
+vk::PresentModeKHR BVulkanSwapchain::GetPresentMode() const {
+    return present_mode_;
+}
+
+const BVulkanSwapchain::Config& BVulkanSwapchain::GetConfig() const {
+    return config_;
+}
+
+void BVulkanSwapchain::SetConfig(const Config& config) {
+    config_ = config;
+    config_.frames_in_flight_ = config.frames_in_flight_ == 0 ? frames_in_flight_ : std::clamp(config.frames_in_flight_, size_t{1}, frames_in_flight_);
 }
 
-void BVulkanSwapchain::SubmitCommandBuffers(const vk::CommandBuffer& buffer, uint32_t image_index) {
-    if (images_in_flight_[image_index]) {
-        [[maybe_unused]] auto res = device_->Device().waitForFences(images_in_flight_[image_index], true, (std::numeric_limits<uint64_t>::max)());
+void BVulkanSwapchain::WaitForFrame() const {
+    auto& timeline = device_->GetFrameTimeline();
+    if (timeline.GetPendingValue() > config_.frames_in_flight_) {
+        timeline.Wait(timeline.GetPendingValue() - config_.frames_in_flight_);
     }
-    images_in_flight_[image_index] = in_flight_fences_[current_frame_];
+}
 
+uint32_t BVulkanSwapchain::AcquireNextImage() {
+    return device_->Device().acquireNextImageKHR(swapchain_, (std::numeric_limits<uint64_t>::max)(), image_available_semaphores_[current_frame_], nullptr).value;
+}
+
+void BVulkanSwapchain::SubmitCommandBuffers(const vk::CommandBuffer& buffer, uint32_t image_index, const std::vector<vk::Semaphore>& wait_semaphores, const std::vector<uint64_t>& wait_values, const std::vector<vk::PipelineStageFlags>& wait_stages) {
+    auto& timeline = device_->GetFrameTimeline();
+    std::vector<vk::Semaphore> semaphores{image_available_semaphores_[current_frame_]};
+    std::vector<uint64_t> values{0};
+    std::vector<vk::PipelineStageFlags> stages{vk::PipelineStageFlagBits::eColorAttachmentOutput};
+    semaphores.insert(semaphores.end(), wait_semaphores.begin(), wait_semaphores.end());
+    values.insert(values.end(), wait_values.begin(), wait_values.end());
+    stages.insert(stages.end(), wait_stages.begin(), wait_stages.end());
+    std::array<vk::Semaphore, 2> signal_semaphores{render_finished_semaphores_[current_frame_], timeline.Semaphore()};
+    std::array<uint64_t, 2> signal_values{0, timeline.GetPendingValue()};
+    vk::TimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info
+        .setWaitSemaphoreValues(values)
+        .setSignalSemaphoreValues(signal_values);
     vk::SubmitInfo submit_info;
-    vk::PipelineStageFlags wait_dst_stage_mask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
     submit_info
-        .setWaitSemaphoreCount(1)
-        .setWaitSemaphores(image_available_semaphores_[current_frame_])
-        .setWaitDstStageMask(wait_dst_stage_mask)
+        .setPNext(&timeline_info)
+        .setWaitSemaphoreCount(static_cast<uint32_t>(semaphores.size()))
+        .setWaitSemaphores(semaphores)
+        .setWaitDstStageMask(stages)
         .setCommandBufferCount(1)
         .setCommandBuffers(buffer)
-        .setSignalSemaphoreCount(1)
-        .setSignalSemaphores(render_finished_semaphores_[current_frame_]);
-
-    device_->Device().resetFences(in_flight_fences_[current_frame_]);
+        .setSignalSemaphoreCount(static_cast<uint32_t>(signal_semaphores.size()))
+        .setSignalSemaphores(signal_semaphores);
 
-    device_->GetGraphicsQueue().submit(submit_info, in_flight_fences_[current_frame_]);
+    device_->GetGraphicsQueue().submit(submit_info);
+    timeline.Advance();
 
     vk::PresentInfoKHR present_info;
     present_info
@@ -93,25 +133,84 @@ void BVulkanSwapchain::SubmitCommandBuffers(const vk::CommandBuffer& buffer, uin
         .setSwapchains(swapchain_)
         .setImageIndices(image_index);
 
+    current_frame_ = (current_frame_ + 1) % frames_in_flight_;
     [[maybe_unused]] auto res = device_->GetPresentQueue().presentKHR(present_info);
-    current_frame_ = (current_frame_ + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
-const vk::Framebuffer& BVulkanSwapchain::GetFrameBuffer(size_t index) const {
-    return swapchain_frame_buffers_[index];
+size_t BVulkanSwapchain::GetCurrentFrame() const {
+    return current_frame_;
 }
 
-void BVulkanSwapchain::CreateSwapchain() {
+const vk::Framebuffer& BVulkanSwapchain::GetFrameBuffer(size_t image_index, size_t frame_index) const {
+    return swapchain_frame_buffers_[image_index * frames_in_flight_ + frame_index];
+}
+
+const vk::Image& BVulkanSwapchain::GetSwapchainImage(size_t index) const {
+    return swapchain_images_[index];
+}
+
+const vk::ImageView& BVulkanSwapchain::GetSwapchainImageView(size_t index) const {
+    return swapchain_image_views_[index];
+}
+
+const BVulkanImage& BVulkanSwapchain::GetDepthImage(size_t frame_index) const {
+    return depth_images_[frame_index];
+}
+
+void BVulkanSwapchain::Recreate(int width, int height) {
+    canvas_extent_.setWidth(width);
+    canvas_extent_.setHeight(height);
+    auto old_swapchain = swapchain_;
+    auto old_format = swapchain_image_format_;
+    auto depth_changed = depth_sampled_ != config_.sampled_depth_;
+    depth_sampled_ = config_.sampled_depth_;
+    RetireSwapchain();
+    CreateSwapchain(old_swapchain);
+    if ((swapchain_image_format_ != old_format || depth_changed) && render_pass_) {
+        device_->GetDeletionQueue().Push([device = device_, render_pass = render_pass_]() {
+            device->Device().destroyRenderPass(render_pass);
+        });
+        CreateRenderPass();
+    }
+    if (depth_changed) {
+        depth_images_.clear();
+    }
+    CreateDepthResources();
+    if (render_pass_) {
+        CreateFrameBuffers();
+    }
+}
+
+void BVulkanSwapchain::RecreateDepthResources() {
+    if (depth_sampled_ == config_.sampled_depth_) {
+        return;
+    }
+    depth_sampled_ = config_.sampled_depth_;
+    if (render_pass_) {
+        device_->GetDeletionQueue().Push([device = device_, render_pass = render_pass_, frame_buffers = swapchain_frame_buffers_]() {
+            for (auto framebuffer : frame_buffers) {
+                device->Device().destroyFramebuffer(framebuffer);
+            }
+            device->Device().destroyRenderPass(render_pass);
+        });
+        swapchain_frame_buffers_.clear();
+        CreateRenderPass();
+    }
+    depth_images_.clear();
+    CreateDepthResources();
+    if (render_pass_) {
+        CreateFrameBuffers();
+    }
+}
+
+void BVulkanSwapchain::CreateSwapchain(vk::SwapchainKHR old_swapchain) {
     auto swapchain_support = device_->GetSwapchainSupport();
     auto surface_format = ChooseSwapSurfaceFormat(swapchain_support.formats_);
     swapchain_image_format_ = surface_format.format;
-    auto present_mode = ChooseSwapPresentMode(swapchain_support.present_modes_);
+    present_mode_ = ChooseSwapPresentMode(swapchain_support.present_modes_, config_.present_mode_);
     auto extent = ChooseSwapExtent(swapchain_support.capabilities_);
     swapchain_extent_ = extent;
-    uint32_t image_count = swapchain_support.capabilities_.minImageCount + 1;
-    if (swapchain_support.capabilities_.maxImageCount > 0 && image_count > swapchain_support.capabilities_.maxImageCount) {
-        image_count = swapchain_support.capabilities_.maxImageCount;
-    }
+    auto image_count = ChooseImageCount(swapchain_support.capabilities_);
     vk::SwapchainCreateInfoKHR create_info{};
     create_info
         .setSurface(device_->Surface())
@@ -123,8 +222,9 @@ void BVulkanSwapchain::CreateSwapchain() {
         .setImageUsage(vk::ImageUsageFlagBits::eColorAttachment)
         .setPreTransform(swapchain_support.capabilities_.currentTransform)
         .setCompositeAlpha(vk::CompositeAlphaFlagBitsKHR::eOpaque)
-        .setPresentMode(present_mode)
-        .setClipped(true);
+        .setPresentMode(present_mode_)
+        .setClipped(true)
+        .setOldSwapchain(old_swapchain);
     auto indices = device_->FindPhysicalQueueFamilies();
     if (indices.graphics_family_ != indices.present_family_) {
         std::array<uint32_t, 2> queue_family_indices{indices.graphics_family_, indices.present_family_};
@@ -144,13 +244,29 @@ void BVulkanSwapchain::CreateSwapchain() {
     }
 }
 
+void BVulkanSwapchain::RetireSwapchain() {
+    device_->GetDeletionQueue().Push([device = device_, swapchain = swapchain_, image_views = swapchain_image_views_, frame_buffers = swapchain_frame_buffers_]() {
+        for (auto framebuffer : frame_buffers) {
+            device->Device().destroyFramebuffer(framebuffer);
+        }
+        for (auto image_view : image_views) {
+            device->Device().destroyImageView(image_view);
+        }
+        device->Device().destroySwapchainKHR(swapchain);
+    });
+    swapchain_ = nullptr;
+    swapchain_images_.clear();
+    swapchain_image_views_.clear();
+    swapchain_frame_buffers_.clear();
+}
+
 void BVulkanSwapchain::CreateRenderPass() {
     vk::AttachmentDescription depth_attachment{};
     depth_attachment
-        .setFormat(FindDepthFormat())
+        .setFormat(depth_format_)
         .setSamples(vk::SampleCountFlagBits::e1)
         .setLoadOp(vk::AttachmentLoadOp::eClear)
-        .setStoreOp(vk::AttachmentStoreOp::eDontCare)
+        .setStoreOp(GetDepthStoreOp())
         .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
         .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
         .setInitialLayout(vk::ImageLayout::eUndefined)
@@ -183,7 +299,7 @@ void BVulkanSwapchain::CreateRenderPass() {
     dependency
         .setSrcSubpass(VK_SUBPASS_EXTERNAL)
         .setSrcAccessMask(vk::AccessFlagBits::eNone)
-        .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eComputeShader)
         .setDstSubpass(0)
         .setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests)
         .setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
@@ -200,21 +316,26 @@ void BVulkanSwapchain::CreateRenderPass() {
 }
 
 void BVulkanSwapchain::CreateDepthResources() {
-    auto depth_format = FindDepthFormat();
     auto swapchain_extent = GetSwapchainExtent();
-    depth_images_.resize(GetImageCount());
-    depth_image_memories_.resize(GetImageCount());
-    depth_image_views_.resize(GetImageCount());
-    for (size_t i = 0; i < depth_images_.size(); ++i) {
-        device_->CreateImage(swapchain_extent.width, swapchain_extent.height, depth_format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, depth_images_[i], depth_image_memories_[i]);
-        depth_image_views_[i] = device_->CreateImageView(depth_images_[i], depth_format, vk::ImageAspectFlagBits::eDepth);
+    auto fits = [&swapchain_extent](const BVulkanImage& image) {
+        return image.Extent().width >= swapchain_extent.width && image.Extent().height >= swapchain_extent.height;
+    };
+    if (!std::all_of(depth_images_.begin(), depth_images_.end(), fits)) {
+        depth_images_.clear();
+    }
+    auto width = (swapchain_extent.width + DEPTH_EXTENT_ALIGNMENT - 1) / DEPTH_EXTENT_ALIGNMENT * DEPTH_EXTENT_ALIGNMENT;
+    auto height = (swapchain_extent.height + DEPTH_EXTENT_ALIGNMENT - 1) / DEPTH_EXTENT_ALIGNMENT * DEPTH_EXTENT_ALIGNMENT;
+    auto usage = depth_sampled_ ? vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled : vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransientAttachment;
+    auto properties = depth_sampled_ ? vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal) : vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated;
+    while (depth_images_.size() < frames_in_flight_) {
+        depth_images_.emplace_back(device_, width, height, depth_format_, vk::ImageTiling::eOptimal, usage, properties, vk::ImageAspectFlagBits::eDepth);
     }
 }
 
 void BVulkanSwapchain::CreateFrameBuffers() {
-    swapchain_frame_buffers_.resize(GetImageCount());
-    for (size_t i = 0; i < GetImageCount(); ++i) {
-        std::array<vk::ImageView, 2> attachments{swapchain_image_views_[i], depth_image_views_[i]};
+    swapchain_frame_buffers_.resize(GetImageCount() * frames_in_flight_);
+    for (size_t i = 0; i < swapchain_frame_buffers_.size(); ++i) {
+        std::array<vk::ImageView, 2> attachments{swapchain_image_views_[i / frames_in_flight_], depth_images_[i % frames_in_flight_].View()};
         auto swapchain_extent = GetSwapchainExtent();
         vk::FramebufferCreateInfo framebuffer_info{};
         framebuffer_info
@@ -229,17 +350,12 @@ void BVulkanSwapchain::CreateFrameBuffers() {
 }
 
 void BVulkanSwapchain::CreateSyncObjects() {
-    image_available_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    render_finished_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    in_flight_fences_.resize(MAX_FRAMES_IN_FLIGHT);
-    images_in_flight_.resize(GetImageCount());
+    image_available_semaphores_.resize(frames_in_flight_);
+    render_finished_semaphores_.resize(frames_in_flight_);
     vk::SemaphoreCreateInfo semaphore_info{};
-    vk::FenceCreateInfo fence_info{};
-    fence_info.setFlags(vk::FenceCreateFlagBits::eSignaled);
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    for (size_t i = 0; i < frames_in_flight_; ++i) {
         image_available_semaphores_[i] = device_->Device().createSemaphore(semaphore_info);
         render_finished_semaphores_[i] = device_->Device().createSemaphore(semaphore_info);
-        in_flight_fences_[i] = device_->Device().createFence(fence_info);
     }
 }
 
@@ -252,15 +368,24 @@ vk::SurfaceFormatKHR BVulkanSwapchain::ChooseSwapSurfaceFormat(const std::vector
     return availableFormats[0];
 }
 
-vk::PresentModeKHR BVulkanSwapchain::ChooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes) {
-    for (const auto& available_present_mode : availablePresentModes) {
-        if (available_present_mode == vk::PresentModeKHR::eMailbox) {
-            return available_present_mode;
+vk::PresentModeKHR BVulkanSwapchain::ChooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes, vk::PresentModeKHR preferred_present_mode) {
+    std::array<vk::PresentModeKHR, 2> candidates{preferred_present_mode, preferred_present_mode == vk::PresentModeKHR::eImmediate ? vk::PresentModeKHR::eMailbox : vk::PresentModeKHR::eFifo};
+    for (auto candidate : candidates) {
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), candidate) != availablePresentModes.end()) {
+            return candidate;
         }
     }
     return vk::PresentModeKHR::eFifo;
 }
 
+uint32_t BVulkanSwapchain::ChooseImageCount(const vk::SurfaceCapabilitiesKHR& capabilities) const {
+    auto image_count = config_.image_count_ == 0 ? capabilities.minImageCount + 1 : (std::max)(config_.image_count_, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0) {
+        image_count = (std::min)(image_count, capabilities.maxImageCount);
+    }
+    return image_count;
+}
+
 vk::Extent2D BVulkanSwapchain::ChooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) {
     if (capabilities.currentExtent.width != (std::numeric_limits<uint32_t>::max)()) {
         return capabilities.currentExtent;
@@ -272,9 +397,5 @@ vk::Extent2D BVulkanSwapchain::ChooseSwapExtent(const vk::SurfaceCapabilitiesKHR
 }
 
 vk::Format BVulkanSwapchain::FindDepthFormat() const {
-    return device_->FindSupportedFormat({vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint}, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment);
-}
-
-const vk::Format& BVulkanSwapchain::GetSwapchainImageFormat() const {
-    return swapchain_image_format_;
+    return device_->FindSupportedFormat({vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint}, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage);
 }
@@ -0,0 +1,58 @@
+/**
+ * @file BVulkanThreadPool.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-16
+ */
+
+#include "BVulkanThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+BVulkanThreadPool::BVulkanThreadPool(size_t thread_count) {
+    thread_count = (std::max)(thread_count, size_t{1});
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&BVulkanThreadPool::Run, this);
+    }
+}
+
+BVulkanThreadPool::~BVulkanThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void BVulkanThreadPool::Submit(std::function<void()>&& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+size_t BVulkanThreadPool::ThreadCount() const {
+    return threads_.size();
+}
+
+void BVulkanThreadPool::Run() {
+    while (true) {
+        std::function<void()> task{};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() {
+                return stopping_ || !tasks_.empty();
+            });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
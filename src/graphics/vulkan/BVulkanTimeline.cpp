@@ -0,0 +1,62 @@
+/**
+ * @file BVulkanTimeline.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-21
+ */
+
+#include "BVulkanTimeline.h"
+
+#include <limits>
+
+#include "BVulkanDevice.h"
+
+BVulkanTimeline::BVulkanTimeline(BVulkanDevice* device) : device_(device) {
+    vk::SemaphoreTypeCreateInfo type_info{};
+    type_info
+        .setSemaphoreType(vk::SemaphoreType::eTimeline)
+        .setInitialValue(0);
+    vk::SemaphoreCreateInfo semaphore_info{};
+    semaphore_info.setPNext(&type_info);
+    semaphore_ = device_->Device().createSemaphore(semaphore_info);
+}
+
+BVulkanTimeline::~BVulkanTimeline() {
+    device_->Device().destroySemaphore(semaphore_);
+}
+
+const vk::Semaphore& BVulkanTimeline::Semaphore() const {
+    return semaphore_;
+}
+
+uint64_t BVulkanTimeline::GetSubmittedValue() const {
+    return submitted_value_;
+}
+
+uint64_t BVulkanTimeline::GetPendingValue() const {
+    return submitted_value_ + 1;
+}
+
+uint64_t BVulkanTimeline::GetCompletedValue() const {
+    completed_value_ = device_->Device().getSemaphoreCounterValue(semaphore_, device_->GetDispatcher());
+    return completed_value_;
+}
+
+uint64_t BVulkanTimeline::Advance() {
+    return ++submitted_value_;
+}
+
+bool BVulkanTimeline::IsComplete(uint64_t value) const {
+    return value <= completed_value_ || value <= GetCompletedValue();
+}
+
+void BVulkanTimeline::Wait(uint64_t value) const {
+    if (IsComplete(value)) {
+        return;
+    }
+    vk::SemaphoreWaitInfo wait_info{};
+    wait_info
+        .setSemaphores(semaphore_)
+        .setValues(value);
+    [[maybe_unused]] auto res = device_->Device().waitSemaphores(wait_info, (std::numeric_limits<uint64_t>::max)(), device_->GetDispatcher());
+    completed_value_ = value;
+}
@@ -0,0 +1,380 @@
+/**
+ * @file BVulkanUploader.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-07
+ */
+
+#include "BVulkanUploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "BVulkanDevice.h"
+#include "BVulkanTimeline.h"
+
+namespace {
+
+const vk::PipelineStageFlags READ_STAGES = vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+const vk::AccessFlags READ_ACCESS = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead;
+
+}  // namespace
+
+BVulkanUploader::BVulkanUploader(BVulkanDevice* device, vk::DeviceSize capacity) : device_(device), capacity_(capacity) {
+    auto indices = device_->FindPhysicalQueueFamilies();
+    graphics_family_ = indices.graphics_family_;
+    dedicated_transfer_ = indices.has_transfer_family_;
+    transfer_family_ = dedicated_transfer_ ? indices.transfer_family_ : indices.graphics_family_;
+    queue_ = dedicated_transfer_ ? device_->GetTransferQueue() : device_->GetGraphicsQueue();
+    device_->CreateBuffer(
+        capacity_,
+        vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        ring_buffer_,
+        ring_allocation_);
+    vk::CommandPoolCreateInfo pool_info{};
+    pool_info
+        .setFlags(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+        .setQueueFamilyIndex(transfer_family_);
+    command_pool_ = device_->Device().createCommandPool(pool_info);
+    timeline_ = std::make_unique<BVulkanTimeline>(device_);
+    if (dedicated_transfer_) {
+        pool_info.setQueueFamilyIndex(graphics_family_);
+        return_pool_ = device_->Device().createCommandPool(pool_info);
+        return_timeline_ = std::make_unique<BVulkanTimeline>(device_);
+    }
+}
+
+BVulkanUploader::~BVulkanUploader() {
+    WaitIdle();
+    timeline_.reset();
+    return_timeline_.reset();
+    if (return_pool_) {
+        device_->Device().destroyCommandPool(return_pool_);
+    }
+    device_->Device().destroyCommandPool(command_pool_);
+    device_->DestroyBuffer(ring_buffer_, ring_allocation_);
+}
+
+void BVulkanUploader::UploadBuffer(const void* data, vk::DeviceSize size, const vk::Buffer& dst, vk::DeviceSize dst_offset) {
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        auto chunk = (std::min)(size, capacity_ / 2);
+        auto offset = Reserve(chunk, COPY_ALIGNMENT);
+        memcpy(static_cast<char*>(ring_allocation_.mapped_) + offset, bytes, chunk);
+        auto command_buffer = GetRecordingCommandBuffer();
+        if (dedicated_transfer_) {
+            ReclaimBuffer(command_buffer, dst);
+        }
+        vk::BufferCopy copy_region{};
+        copy_region
+            .setSrcOffset(offset)
+            .setDstOffset(dst_offset)
+            .setSize(chunk);
+        command_buffer.copyBuffer(ring_buffer_, dst, copy_region);
+        auto released = std::any_of(recording_.buffer_releases_.begin(), recording_.buffer_releases_.end(), [&dst](const vk::BufferMemoryBarrier& barrier) {
+            return barrier.buffer == dst;
+        });
+        if (dedicated_transfer_ && !released) {
+            vk::BufferMemoryBarrier release{};
+            release
+                .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+                .setSrcQueueFamilyIndex(transfer_family_)
+                .setDstQueueFamilyIndex(graphics_family_)
+                .setBuffer(dst)
+                .setOffset(0)
+                .setSize(VK_WHOLE_SIZE);
+            recording_.buffer_releases_.push_back(release);
+        }
+        bytes += chunk;
+        dst_offset += chunk;
+        size -= chunk;
+    }
+}
+
+void BVulkanUploader::UploadImage(const void* data, vk::DeviceSize size, const vk::Image& dst, vk::Extent3D extent, vk::ImageAspectFlags aspect, vk::ImageLayout final_layout) {
+    if (size > capacity_ / 2) {
+        throw std::runtime_error("Image upload exceeds the staging ring capacity.");
+    }
+    auto offset = Reserve(size, COPY_ALIGNMENT);
+    memcpy(static_cast<char*>(ring_allocation_.mapped_) + offset, data, size);
+    auto command_buffer = GetRecordingCommandBuffer();
+    vk::ImageSubresourceRange range{};
+    range
+        .setAspectMask(aspect)
+        .setBaseMipLevel(0)
+        .setLevelCount(1)
+        .setBaseArrayLayer(0)
+        .setLayerCount(1);
+    vk::ImageMemoryBarrier to_transfer{};
+    to_transfer
+        .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+        .setOldLayout(vk::ImageLayout::eUndefined)
+        .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(dst)
+        .setSubresourceRange(range);
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, to_transfer);
+    vk::BufferImageCopy copy_region{};
+    copy_region
+        .setBufferOffset(offset)
+        .setBufferRowLength(0)
+        .setBufferImageHeight(0)
+        .setImageSubresource({aspect, 0, 0, 1})
+        .setImageOffset({0, 0, 0})
+        .setImageExtent(extent);
+    command_buffer.copyBufferToImage(ring_buffer_, dst, vk::ImageLayout::eTransferDstOptimal, copy_region);
+    vk::ImageMemoryBarrier to_final{};
+    to_final
+        .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+        .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setNewLayout(final_layout)
+        .setImage(dst)
+        .setSubresourceRange(range);
+    if (dedicated_transfer_) {
+        to_final
+            .setSrcQueueFamilyIndex(transfer_family_)
+            .setDstQueueFamilyIndex(graphics_family_);
+        recording_.image_releases_.push_back(to_final);
+    } else {
+        to_final
+            .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, READ_STAGES, {}, nullptr, nullptr, to_final);
+    }
+}
+
+void BVulkanUploader::Flush() {
+    if (!recording_.command_buffer_) {
+        return;
+    }
+    uint64_t return_value{0};
+    if (dedicated_transfer_) {
+        return_value = SubmitReturns();
+        recording_.command_buffer_.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eBottomOfPipe,
+            {},
+            nullptr,
+            recording_.buffer_releases_,
+            recording_.image_releases_);
+        for (auto barrier : recording_.buffer_releases_) {
+            graphics_owned_.insert(barrier.buffer);
+            buffer_acquires_.push_back(barrier.setSrcAccessMask({}).setDstAccessMask(READ_ACCESS));
+        }
+        for (auto barrier : recording_.image_releases_) {
+            image_acquires_.push_back(barrier.setSrcAccessMask({}).setDstAccessMask(vk::AccessFlagBits::eShaderRead));
+        }
+        acquire_value_ = timeline_->GetPendingValue();
+    } else {
+        vk::MemoryBarrier barrier{};
+        barrier
+            .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setDstAccessMask(READ_ACCESS);
+        recording_.command_buffer_.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, READ_STAGES, {}, barrier, nullptr, nullptr);
+    }
+    recording_.command_buffer_.end();
+    recording_.value_ = timeline_->GetPendingValue();
+    vk::PipelineStageFlags wait_stage{vk::PipelineStageFlagBits::eTransfer};
+    vk::TimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info.setSignalSemaphoreValues(recording_.value_);
+    vk::SubmitInfo submit_info{};
+    if (return_value != 0) {
+        timeline_info.setWaitSemaphoreValues(return_value);
+        submit_info
+            .setWaitSemaphores(return_timeline_->Semaphore())
+            .setWaitDstStageMask(wait_stage);
+    }
+    submit_info
+        .setPNext(&timeline_info)
+        .setCommandBufferCount(1)
+        .setCommandBuffers(recording_.command_buffer_)
+        .setSignalSemaphoreCount(1)
+        .setSignalSemaphores(timeline_->Semaphore());
+    queue_.submit(submit_info);
+    timeline_->Advance();
+    recording_.buffer_releases_.clear();
+    recording_.image_releases_.clear();
+    recording_.buffer_returns_.clear();
+    in_flight_.push_back(recording_);
+    recording_ = {};
+    Retire(false);
+}
+
+void BVulkanUploader::WaitIdle() {
+    Flush();
+    while (!in_flight_.empty()) {
+        Retire(true);
+    }
+    if (return_timeline_) {
+        return_timeline_->Wait(return_timeline_->GetSubmittedValue());
+    }
+}
+
+void BVulkanUploader::RecordAcquires(const vk::CommandBuffer& command_buffer, std::vector<vk::Semaphore>& wait_semaphores, std::vector<uint64_t>& wait_values, std::vector<vk::PipelineStageFlags>& wait_stages) {
+    if (!buffer_acquires_.empty() || !image_acquires_.empty()) {
+        command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, READ_STAGES, {}, nullptr, buffer_acquires_, image_acquires_);
+        buffer_acquires_.clear();
+        image_acquires_.clear();
+    }
+    if (acquire_value_ != 0) {
+        wait_semaphores.push_back(timeline_->Semaphore());
+        wait_values.push_back(acquire_value_);
+        wait_stages.push_back(READ_STAGES);
+        acquire_value_ = 0;
+    }
+}
+
+bool BVulkanUploader::HasDedicatedTransferQueue() const {
+    return dedicated_transfer_;
+}
+
+uint64_t BVulkanUploader::GetRecordedValue() const {
+    return recording_.command_buffer_ ? timeline_->GetPendingValue() : timeline_->GetSubmittedValue();
+}
+
+bool BVulkanUploader::IsComplete(uint64_t value) const {
+    return timeline_->IsComplete(value);
+}
+
+vk::DeviceSize BVulkanUploader::Reserve(vk::DeviceSize size, vk::DeviceSize alignment) {
+    while (true) {
+        auto offset = (head_ + alignment - 1) / alignment * alignment;
+        auto needed = offset - head_ + size;
+        if (offset + size > capacity_) {
+            offset = 0;
+            needed = capacity_ - head_ + size;
+        }
+        if (used_ + needed <= capacity_) {
+            head_ = offset + size;
+            used_ += needed;
+            recording_.bytes_ += needed;
+            return offset;
+        }
+        if (in_flight_.empty()) {
+            Flush();
+        }
+        Retire(true);
+    }
+}
+
+vk::CommandBuffer BVulkanUploader::GetRecordingCommandBuffer() {
+    if (recording_.command_buffer_) {
+        return recording_.command_buffer_;
+    }
+    if (free_command_buffers_.empty()) {
+        vk::CommandBufferAllocateInfo allocate_info{};
+        allocate_info
+            .setLevel(vk::CommandBufferLevel::ePrimary)
+            .setCommandPool(command_pool_)
+            .setCommandBufferCount(1);
+        recording_.command_buffer_ = device_->Device().allocateCommandBuffers(allocate_info).at(0);
+    } else {
+        recording_.command_buffer_ = free_command_buffers_.back();
+        free_command_buffers_.pop_back();
+    }
+    vk::CommandBufferBeginInfo begin_info{};
+    begin_info.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    recording_.command_buffer_.begin(begin_info);
+    return recording_.command_buffer_;
+}
+
+void BVulkanUploader::ReclaimBuffer(const vk::CommandBuffer& command_buffer, const vk::Buffer& buffer) {
+    if (graphics_owned_.erase(buffer) == 0) {
+        return;
+    }
+    vk::BufferMemoryBarrier barrier{};
+    barrier
+        .setSrcQueueFamilyIndex(graphics_family_)
+        .setDstQueueFamilyIndex(transfer_family_)
+        .setBuffer(buffer)
+        .setOffset(0)
+        .setSize(VK_WHOLE_SIZE);
+    recording_.buffer_returns_.push_back(barrier);
+    barrier.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, barrier, nullptr);
+}
+
+uint64_t BVulkanUploader::SubmitReturns() {
+    while (!returns_in_flight_.empty() && return_timeline_->IsComplete(returns_in_flight_.front().value_)) {
+        free_return_buffers_.push_back(returns_in_flight_.front().command_buffer_);
+        returns_in_flight_.pop_front();
+    }
+    if (recording_.buffer_returns_.empty()) {
+        return 0;
+    }
+    Batch batch{};
+    if (free_return_buffers_.empty()) {
+        vk::CommandBufferAllocateInfo allocate_info{};
+        allocate_info
+            .setLevel(vk::CommandBufferLevel::ePrimary)
+            .setCommandPool(return_pool_)
+            .setCommandBufferCount(1);
+        batch.command_buffer_ = device_->Device().allocateCommandBuffers(allocate_info).at(0);
+    } else {
+        batch.command_buffer_ = free_return_buffers_.back();
+        free_return_buffers_.pop_back();
+    }
+    vk::CommandBufferBeginInfo begin_info{};
+    begin_info.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    batch.command_buffer_.begin(begin_info);
+    std::vector<vk::BufferMemoryBarrier> pending_acquires{};
+    for (const auto& barrier : recording_.buffer_returns_) {
+        auto it = std::find_if(buffer_acquires_.begin(), buffer_acquires_.end(), [&barrier](const vk::BufferMemoryBarrier& acquire) {
+            return acquire.buffer == barrier.buffer;
+        });
+        if (it != buffer_acquires_.end()) {
+            pending_acquires.push_back(*it);
+            buffer_acquires_.erase(it);
+        }
+    }
+    if (!pending_acquires.empty()) {
+        batch.command_buffer_.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, pending_acquires, nullptr);
+    }
+    batch.command_buffer_.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, recording_.buffer_returns_, nullptr);
+    batch.command_buffer_.end();
+    batch.value_ = return_timeline_->GetPendingValue();
+    std::vector<vk::Semaphore> wait_semaphores{};
+    std::vector<uint64_t> wait_values{};
+    std::vector<vk::PipelineStageFlags> wait_stages{};
+    if (!pending_acquires.empty()) {
+        wait_semaphores.push_back(timeline_->Semaphore());
+        wait_values.push_back(timeline_->GetSubmittedValue());
+        wait_stages.push_back(vk::PipelineStageFlagBits::eTopOfPipe);
+    }
+    vk::TimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info
+        .setWaitSemaphoreValues(wait_values)
+        .setSignalSemaphoreValues(batch.value_);
+    vk::SubmitInfo submit_info{};
+    submit_info
+        .setPNext(&timeline_info)
+        .setWaitSemaphores(wait_semaphores)
+        .setWaitDstStageMask(wait_stages)
+        .setCommandBuffers(batch.command_buffer_)
+        .setSignalSemaphores(return_timeline_->Semaphore());
+    device_->GetGraphicsQueue().submit(submit_info);
+    return_timeline_->Advance();
+    returns_in_flight_.push_back(batch);
+    return batch.value_;
+}
+
+void BVulkanUploader::Retire(bool wait) {
+    while (!in_flight_.empty()) {
+        auto& batch = in_flight_.front();
+        if (wait) {
+            timeline_->Wait(batch.value_);
+            wait = false;
+        } else if (!timeline_->IsComplete(batch.value_)) {
+            break;
+        }
+        used_ -= batch.bytes_;
+        free_command_buffers_.push_back(batch.command_buffer_);
+        in_flight_.pop_front();
+    }
+    if (used_ == 0) {
+        head_ = 0;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+/**
+ * @file BTest.h
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-22
+ */
+
+#include <cstdio>
+
+inline bool Check(bool condition, const char* message) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", message);
+    }
+    return condition;
+}
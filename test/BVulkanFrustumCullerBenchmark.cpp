@@ -0,0 +1,139 @@
+/**
+ * @file BVulkanFrustumCullerBenchmark.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-22
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "BVulkanFrustumCuller.h"
+
+namespace {
+
+constexpr float SCENE_EXTENT{500.0F};
+constexpr float HALF_SIZE{0.5F};
+constexpr float BOUNDARY_EPSILON{1.0e-3F};
+constexpr uint32_t DEFAULT_OBJECT_COUNT{100000};
+constexpr uint32_t ITERATIONS{100};
+constexpr double CULL_BUDGET_MS{1.0};
+
+struct Scene {
+    std::vector<glm::mat4> transforms_{};
+    glm::mat4 view_projection_{1.0F};
+};
+
+Scene MakeScene(uint32_t object_count, uint32_t seed) {
+    Scene scene{};
+    std::mt19937 engine(seed);
+    std::uniform_real_distribution<float> position(-SCENE_EXTENT, SCENE_EXTENT);
+    for (uint32_t i = 0; i < object_count; ++i) {
+        scene.transforms_.push_back(glm::translate(glm::mat4(1.0F), glm::vec3(position(engine), position(engine), position(engine))));
+    }
+    auto projection = glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, 2.0F * SCENE_EXTENT);
+    auto view = glm::lookAt(glm::vec3(0.0F), glm::vec3(0.0F, 0.0F, -1.0F), glm::vec3(0.0F, 1.0F, 0.0F));
+    scene.view_projection_ = projection * view;
+    return scene;
+}
+
+float PlaneDistance(const glm::vec4& plane, const glm::vec3& center) {
+    return glm::dot(glm::vec3(plane), center) + glm::dot(glm::abs(glm::vec3(plane)), glm::vec3(HALF_SIZE)) + plane.w;
+}
+
+std::vector<uint32_t> CullLinear(const Scene& scene) {
+    auto planes = BVulkanFrustumCuller::ExtractFrustumPlanes(scene.view_projection_);
+    std::vector<uint32_t> visible{};
+    for (uint32_t handle = 0; handle < scene.transforms_.size(); ++handle) {
+        auto center = glm::vec3(scene.transforms_[handle][3]);
+        auto outside = std::any_of(planes.begin(), planes.end(), [&center](const glm::vec4& plane) {
+            return PlaneDistance(plane, center) < 0.0F;
+        });
+        if (!outside) {
+            visible.push_back(handle);
+        }
+    }
+    return visible;
+}
+
+bool MatchesLinear(const Scene& scene, const std::vector<uint32_t>& visible, const std::vector<uint32_t>& reference) {
+    auto planes = BVulkanFrustumCuller::ExtractFrustumPlanes(scene.view_projection_);
+    std::vector<uint32_t> mismatches{};
+    std::set_symmetric_difference(visible.begin(), visible.end(), reference.begin(), reference.end(), std::back_inserter(mismatches));
+    return std::all_of(mismatches.begin(), mismatches.end(), [&](uint32_t handle) {
+        auto center = glm::vec3(scene.transforms_[handle][3]);
+        return std::any_of(planes.begin(), planes.end(), [&center](const glm::vec4& plane) {
+            return std::abs(PlaneDistance(plane, center)) < BOUNDARY_EPSILON;
+        });
+    });
+}
+
+template <typename Function>
+double MeasureMilliseconds(uint32_t iterations, Function&& function) {
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        function(i);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    auto object_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_OBJECT_COUNT;
+    auto scene = MakeScene(object_count, 20230522);
+
+    BVulkanFrustumCuller culler{};
+    for (const auto& transform : scene.transforms_) {
+        culler.Insert(glm::vec3(-HALF_SIZE), glm::vec3(HALF_SIZE), transform);
+    }
+    std::vector<uint32_t> visible{};
+    auto build = MeasureMilliseconds(1, [&](uint32_t) {
+        culler.Cull(scene.view_projection_, visible);
+    });
+    auto cull = MeasureMilliseconds(ITERATIONS, [&](uint32_t) {
+        culler.Cull(scene.view_projection_, visible);
+    });
+    std::vector<uint32_t> reference{};
+    auto linear = MeasureMilliseconds(ITERATIONS, [&](uint32_t) {
+        reference = CullLinear(scene);
+    });
+    std::sort(visible.begin(), visible.end());
+    auto matches = MatchesLinear(scene, visible, reference);
+    std::printf("objects %u, visible %zu (linear %zu)\n", object_count, visible.size(), reference.size());
+
+    std::mt19937 engine(20230523);
+    std::uniform_real_distribution<float> offset(-1.0F, 1.0F);
+    auto moved_count = object_count / 10;
+    auto refit = MeasureMilliseconds(ITERATIONS, [&](uint32_t iteration) {
+        for (uint32_t i = 0; i < moved_count; ++i) {
+            auto handle = (iteration * moved_count + i) % object_count;
+            scene.transforms_[handle] = glm::translate(scene.transforms_[handle], glm::vec3(offset(engine), offset(engine), offset(engine)));
+            culler.Update(handle, scene.transforms_[handle]);
+        }
+        culler.Cull(scene.view_projection_, visible);
+    });
+
+    std::printf("build + cull       %.3f ms\n", build);
+    std::printf("cull               %.3f ms\n", cull);
+    std::printf("linear cull        %.3f ms\n", linear);
+    std::printf("move 10%% + cull    %.3f ms\n", refit);
+    auto passed = matches;
+    if (!matches) {
+        std::fprintf(stderr, "FAILED: BVH and linear cull disagree\n");
+    }
+#if defined(NOT_DEBUG)
+    if (object_count <= DEFAULT_OBJECT_COUNT && cull > CULL_BUDGET_MS) {
+        std::fprintf(stderr, "FAILED: cull took %.3f ms, budget is %.3f ms\n", cull, CULL_BUDGET_MS);
+        passed = false;
+    }
+#endif
+    return passed ? 0 : 1;
+}
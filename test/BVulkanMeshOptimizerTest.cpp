@@ -0,0 +1,89 @@
+/**
+ * @file BVulkanMeshOptimizerTest.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-22
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BTest.h"
+#include "BVulkanMeshOptimizer.h"
+
+namespace {
+
+struct Mesh {
+    std::vector<std::array<float, 3>> positions_{};
+    std::vector<uint32_t> indices_{};
+};
+
+Mesh MakeSphere(uint32_t rings, uint32_t segments) {
+    Mesh mesh{};
+    for (uint32_t ring = 0; ring <= rings; ++ring) {
+        auto theta = static_cast<float>(ring) / static_cast<float>(rings) * 3.14159265F;
+        for (uint32_t segment = 0; segment <= segments; ++segment) {
+            auto phi = static_cast<float>(segment) / static_cast<float>(segments) * 6.28318531F;
+            mesh.positions_.push_back({std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+        }
+    }
+    for (uint32_t ring = 0; ring < rings; ++ring) {
+        for (uint32_t segment = 0; segment < segments; ++segment) {
+            auto a = ring * (segments + 1) + segment;
+            auto b = a + segments + 1;
+            mesh.indices_.insert(mesh.indices_.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+    return mesh;
+}
+
+void ShuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed) {
+    std::mt19937 engine(seed);
+    auto triangle_count = indices.size() / 3;
+    for (auto i = triangle_count; i > 1; --i) {
+        auto j = static_cast<size_t>(engine() % i);
+        for (size_t k = 0; k < 3; ++k) {
+            std::swap(indices[(i - 1) * 3 + k], indices[j * 3 + k]);
+        }
+    }
+}
+
+std::vector<std::array<std::array<float, 3>, 3>> TriangleSet(const std::vector<std::array<float, 3>>& positions, const std::vector<uint32_t>& indices) {
+    std::vector<std::array<std::array<float, 3>, 3>> triangles{};
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::array<std::array<float, 3>, 3> triangle{positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]]};
+        auto first = std::min_element(triangle.begin(), triangle.end());
+        std::rotate(triangle.begin(), first, triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+}  // namespace
+
+int main() {
+    auto mesh = MakeSphere(48, 64);
+    ShuffleTriangles(mesh.indices_, 20230522);
+    auto vertex_count = mesh.positions_.size();
+    auto before = BVulkanMeshOptimizer::AnalyzeVertexCache(mesh.indices_, vertex_count);
+
+    auto indices = BVulkanMeshOptimizer::OptimizeVertexCache(mesh.indices_, vertex_count);
+    indices = BVulkanMeshOptimizer::OptimizeOverdraw(indices, mesh.positions_[0].data(), sizeof(mesh.positions_[0]), vertex_count);
+    auto remap = BVulkanMeshOptimizer::OptimizeVertexFetch(indices, vertex_count);
+    indices = BVulkanMeshOptimizer::RemapIndices(indices, remap);
+    auto positions = BVulkanMeshOptimizer::RemapVertices(mesh.positions_, remap);
+    auto after = BVulkanMeshOptimizer::AnalyzeVertexCache(indices, positions.size());
+
+    std::printf("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr_, after.acmr_, before.atvr_, after.atvr_);
+    auto passed = true;
+    passed &= Check(indices.size() == mesh.indices_.size(), "index count changed");
+    passed &= Check(TriangleSet(positions, indices) == TriangleSet(mesh.positions_, mesh.indices_), "triangle set or winding changed");
+    passed &= Check(after.acmr_ <= before.acmr_, "ACMR got worse");
+    passed &= Check(after.atvr_ <= before.atvr_, "ATVR got worse");
+    return passed ? 0 : 1;
+}
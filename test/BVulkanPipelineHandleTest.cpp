@@ -0,0 +1,76 @@
+/**
+ * @file BVulkanPipelineHandleTest.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-22
+ */
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "BTest.h"
+#include "BVulkanPipelineHandle.h"
+
+namespace {
+
+using PipelineFuture = BVulkanPipelineHandle::PipelineFuture;
+using PipelinePromise = std::promise<std::shared_ptr<BVulkanPipeline>>;
+
+constexpr std::chrono::seconds WAIT_TIMEOUT{5};
+
+std::shared_ptr<BVulkanPipeline> MakePipeline(int& storage) {
+    return std::shared_ptr<BVulkanPipeline>(std::shared_ptr<void>(), reinterpret_cast<BVulkanPipeline*>(&storage));
+}
+
+PipelineFuture MakeReady(const std::shared_ptr<BVulkanPipeline>& pipeline) {
+    PipelinePromise promise{};
+    promise.set_value(pipeline);
+    return promise.get_future().share();
+}
+
+}  // namespace
+
+int main() {
+    int optimized_storage{0};
+    int linked_storage{0};
+    int fallback_storage{0};
+    auto optimized = MakePipeline(optimized_storage);
+    auto linked = MakePipeline(linked_storage);
+    auto fallback = MakePipeline(fallback_storage);
+    auto passed = true;
+
+    BVulkanPipelineHandle empty{};
+    passed &= Check(!empty && empty.Get() == nullptr, "an empty handle returned a pipeline");
+
+    PipelinePromise optimized_promise{};
+    PipelinePromise linked_promise{};
+    BVulkanPipelineHandle handle(optimized_promise.get_future().share(), linked_promise.get_future().share(), MakeReady(fallback));
+    passed &= Check(handle.Get() == fallback.get(), "a pending handle did not use its fallback");
+
+    linked_promise.set_value(linked);
+    auto wait = std::async(std::launch::async, [&handle]() {
+        handle.Wait();
+    });
+    passed &= Check(wait.wait_for(WAIT_TIMEOUT) == std::future_status::ready, "Wait blocked on the optimized link after the fast link was ready");
+    passed &= Check(handle.Get() == linked.get(), "the fast-linked pipeline was not used");
+    passed &= Check(!handle.IsReady(), "the optimized pipeline was reported ready too early");
+
+    PipelinePromise replacement_promise{};
+    BVulkanPipelineHandle replacement(replacement_promise.get_future().share(), {}, handle.GetUsable());
+    passed &= Check(replacement.Get() == linked.get(), "a replacement did not fall back to the ready fast link");
+
+    optimized_promise.set_value(optimized);
+    passed &= Check(handle.IsReady() && handle.Get() == optimized.get(), "the optimized pipeline was not swapped in");
+
+    PipelinePromise delayed_promise{};
+    BVulkanPipelineHandle delayed(delayed_promise.get_future().share(), {}, {});
+    std::thread producer([&delayed_promise, &optimized]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        delayed_promise.set_value(optimized);
+    });
+    delayed.Wait();
+    producer.join();
+    passed &= Check(delayed.Get() == optimized.get(), "Wait returned before the only link was ready");
+    return passed ? 0 : 1;
+}
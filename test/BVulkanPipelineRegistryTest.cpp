@@ -0,0 +1,65 @@
+/**
+ * @file BVulkanPipelineRegistryTest.cpp
+ * @author liuyulvv (liuyulvv@outlook.com)
+ * @date 2023-05-22
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BTest.h"
+#include "BVulkanModel.h"
+#include "BVulkanPipelineRegistry.h"
+
+namespace {
+
+struct FragmentSpecialization {
+    vk::Bool32 alpha_test_{VK_FALSE};
+    float alpha_cutoff_{0.5F};
+};
+
+const std::vector<uint32_t> VERT_SHADER_CODE{0x07230203, 0x00010000, 0x00000001, 0x00000010, 0x00000000};
+const std::vector<uint32_t> FRAG_SHADER_CODE{0x07230203, 0x00010000, 0x00000001, 0x00000020, 0x00000000};
+
+vk::RenderPass MakeRenderPass(uint64_t value) {
+    return vk::RenderPass(reinterpret_cast<VkRenderPass>(static_cast<uintptr_t>(value)));
+}
+
+BVulkanPipeline::PipelineConfigInfo MakeConfig(BVulkanModel::VertexFormat vertex_format, const vk::RenderPass& render_pass, const FragmentSpecialization& fragment_specialization) {
+    auto config = BVulkanPipeline::DefaultPipelineConfigInfo(vk::PrimitiveTopology::eTriangleList);
+    config.binding_descriptions_ = BVulkanModel::GetBindingDescriptions(vertex_format);
+    config.attribute_descriptions_ = BVulkanModel::GetAttributeDescriptions(vertex_format);
+    config.render_pass_ = render_pass;
+    config.color_attachment_format_ = vk::Format::eB8G8R8A8Srgb;
+    config.depth_attachment_format_ = vk::Format::eD32Sfloat;
+    config.frag_specialization_ = BVulkanPipeline::MakeSpecializationInfo(fragment_specialization, 1);
+    return config;
+}
+
+std::string MakeKey(const BVulkanPipeline::PipelineConfigInfo& config, const std::vector<uint32_t>& frag_shader_code = FRAG_SHADER_CODE) {
+    return BVulkanPipelineRegistry::MakeKey("shader.vert", VERT_SHADER_CODE, "shader.frag", frag_shader_code, config);
+}
+
+}  // namespace
+
+int main() {
+    FragmentSpecialization fragment_specialization{};
+    auto key = MakeKey(MakeConfig(BVulkanModel::VertexFormat::eFloat, MakeRenderPass(1), fragment_specialization));
+
+    auto passed = true;
+    passed &= Check(MakeKey(MakeConfig(BVulkanModel::VertexFormat::eFloat, MakeRenderPass(1), fragment_specialization)) == key, "identical configs produced different keys");
+    passed &= Check(MakeKey(MakeConfig(BVulkanModel::VertexFormat::eFloat, MakeRenderPass(2), fragment_specialization)) == key, "compatible render passes produced different keys");
+    passed &= Check(MakeKey(MakeConfig(BVulkanModel::VertexFormat::eFloat, vk::RenderPass{}, fragment_specialization)) != key, "dynamic rendering shared a key with a render pass");
+    passed &= Check(MakeKey(MakeConfig(BVulkanModel::VertexFormat::ePackedSnorm16, MakeRenderPass(1), fragment_specialization)) != key, "vertex formats shared a key");
+    passed &= Check(MakeKey(MakeConfig(BVulkanModel::VertexFormat::eFloat, MakeRenderPass(1), fragment_specialization), VERT_SHADER_CODE) != key, "fragment shaders shared a key");
+
+    auto alpha_test = fragment_specialization;
+    alpha_test.alpha_test_ = VK_TRUE;
+    passed &= Check(MakeKey(MakeConfig(BVulkanModel::VertexFormat::eFloat, MakeRenderPass(1), alpha_test)) != key, "specialization constants shared a key");
+
+    auto depth_format = MakeConfig(BVulkanModel::VertexFormat::eFloat, MakeRenderPass(1), fragment_specialization);
+    depth_format.depth_attachment_format_ = vk::Format::eD24UnormS8Uint;
+    passed &= Check(MakeKey(depth_format) != key, "depth formats shared a key");
+    return passed ? 0 : 1;
+}